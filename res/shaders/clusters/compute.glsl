@@ -0,0 +1,92 @@
+// //////////////////////////////////////////////////////// GLSL version //
+#version 430 core
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/clusters.glsl"
+
+// ///////////////////////////////////////////////////////// Work group //
+// One work group per depth slice, one invocation per screen tile
+layout(local_size_x = CLUSTER_GRID_X,
+       local_size_y = CLUSTER_GRID_Y,
+       local_size_z = 1) in;
+
+const uint GROUP_SIZE = CLUSTER_GRID_X * CLUSTER_GRID_Y;
+
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform mat4 view;
+uniform mat4 inverseProjection;
+uniform int clusterLightCount;
+
+// ////////////////////////////////////////////////////// Shared memory //
+// View-space bounding spheres of the batch of lights being tested
+shared vec4 batch[GROUP_SIZE];
+
+// //////////////////////////////////////////////////////// Cluster bounds //
+// View-space point on the near plane under a normalised screen position
+vec3 nearPlanePoint(vec2 screen) {
+    vec4 point = inverseProjection * vec4(screen * 2.0 - 1.0, -1.0, 1.0);
+    return point.xyz / point.w;
+}
+
+// Where the ray from the eye through a near plane point reaches a depth
+vec3 atDepth(vec3 point, float depth) {
+    return point * (depth / -point.z);
+}
+
+bool sphereTouchesBox(vec4 sphere, vec3 boxMin, vec3 boxMax) {
+    vec3 closest = clamp(sphere.xyz, boxMin, boxMax);
+    vec3 offset = closest - sphere.xyz;
+    return dot(offset, offset) <= sphere.w * sphere.w;
+}
+
+// //////////////////////////////////////////////////////////////// Main //
+void main() {
+    uvec3 cluster = gl_GlobalInvocationID;
+    uint index = clusterIndex(cluster);
+
+    // Axis-aligned box around the cluster's frustum segment
+    vec2 tileSize = 1.0 / vec2(CLUSTER_GRID_X, CLUSTER_GRID_Y);
+    vec3 tileMin = nearPlanePoint(vec2(cluster.xy) * tileSize);
+    vec3 tileMax = nearPlanePoint(vec2(cluster.xy + 1u) * tileSize);
+
+    float depthNear = clusterSliceDepth(float(cluster.z));
+    float depthFar = clusterSliceDepth(float(cluster.z + 1u));
+
+    vec3 corners[4] = vec3[4](atDepth(tileMin, depthNear),
+                              atDepth(tileMax, depthNear),
+                              atDepth(tileMin, depthFar),
+                              atDepth(tileMax, depthFar));
+    vec3 boxMin = corners[0], boxMax = corners[0];
+    for (int i = 1; i < 4; ++i) {
+        boxMin = min(boxMin, corners[i]);
+        boxMax = max(boxMax, corners[i]);
+    }
+
+    // Test the lights in batches, each invocation loading one of them
+    uint count = 0u;
+    for (uint first = 0u; first < uint(clusterLightCount);
+         first += GROUP_SIZE) {
+        uint light = first + gl_LocalInvocationIndex;
+        if (light < uint(clusterLightCount)) {
+            vec4 position = clusterLights[light].position;
+            batch[gl_LocalInvocationIndex] =
+                    vec4((view * vec4(position.xyz, 1.0)).xyz, position.w);
+        }
+        barrier();
+
+        uint batchSize = min(GROUP_SIZE, uint(clusterLightCount) - first);
+        for (uint i = 0u; i < batchSize; ++i) {
+            if (count < CLUSTER_MAX_LIGHTS &&
+                sphereTouchesBox(batch[i], boxMin, boxMax)) {
+                clusterLightIndices[index * CLUSTER_MAX_LIGHTS + count] =
+                        first + i;
+                ++count;
+            }
+        }
+        barrier();
+    }
+
+    clusterLightCounts[index] = count;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
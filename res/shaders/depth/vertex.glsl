@@ -1,15 +1,31 @@
 // //////////////////////////////////////////////////////// GLSL version //
 #version 430 core
 
+// ///////////////////////////////////////////////////////// Permutation //
+// Vertices: QUANTIZED_VERTICES 0 or 1, for the PackedVertex layout
+#ifndef QUANTIZED_VERTICES
+#define QUANTIZED_VERTICES 0
+#endif
+
 // ////////////////////////////////////////////////////////////// Inputs //
 layout (location = 0) in vec3 vPosition;
 
 // //////////////////////////////////////////////////////////// Uniforms //
-uniform mat4 transform;
+// Bounding box of the mesh, for quantized positions
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/draw-data.glsl"
 
 // //////////////////////////////////////////////////////////////// Main //
 void main() {
-    gl_Position = transform * vec4(vPosition, 1.0);
+#if QUANTIZED_VERTICES
+    vec3 position = positionOffset + positionScale * vPosition;
+#else
+    vec3 position = vPosition;
+#endif
+    gl_Position = drawParameters().transform * vec4(position, 1.0);
 }
 
 // ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,66 @@
+// //////////////////////////////////////////////////////// GLSL version //
+#version 430 core
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/importance-sampling.glsl"
+
+// ///////////////////////////////////////////////////////// Work group //
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// /////////////////////////////////////////////////////////// Constants //
+const uint SAMPLE_COUNT = 1024u;
+
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform int size;
+
+layout(rg16f, binding = 0) uniform writeonly image2D brdfLut;
+
+// //////////////////////////////////////////////////////////// Geometry //
+// Smith-Schlick with the k used for image-based lighting
+float geometrySchlickIbl(float nDotV, float roughness) {
+    float k = roughness * roughness / 2.0;
+    return nDotV / (nDotV * (1.0 - k) + k);
+}
+
+// //////////////////////////////////////////////////////////////// Main //
+// Scale and bias to the Fresnel reflectance at normal incidence, indexed
+// by n.v and roughness
+void main() {
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= size || texel.y >= size) {
+        return;
+    }
+
+    float nDotV = (float(texel.x) + 0.5) / float(size);
+    float roughness = (float(texel.y) + 0.5) / float(size);
+
+    vec3 v = vec3(sqrt(1.0 - nDotV * nDotV), 0.0, nDotV);
+    vec3 normal = vec3(0.0, 0.0, 1.0);
+
+    float scale = 0.0, bias = 0.0;
+    for (uint i = 0u; i < SAMPLE_COUNT; ++i) {
+        vec3 h = importanceSampleGGX(hammersley(i, SAMPLE_COUNT), normal,
+                                     roughness);
+        vec3 l = normalize(2.0 * dot(v, h) * h - v);
+
+        float nDotL = max(l.z, 0.0);
+        float nDotH = max(h.z, 0.0);
+        float vDotH = max(dot(v, h), 0.0);
+        if (nDotL <= 0.0) {
+            continue;
+        }
+
+        float g = geometrySchlickIbl(nDotV, roughness) *
+                  geometrySchlickIbl(nDotL, roughness);
+        float visibility = g * vDotH / (nDotH * nDotV);
+        float fresnel = pow(1.0 - vDotH, 5.0);
+
+        scale += (1.0 - fresnel) * visibility;
+        bias += fresnel * visibility;
+    }
+
+    imageStore(brdfLut, texel,
+               vec4(scale, bias, 0.0, 0.0) / float(SAMPLE_COUNT));
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,55 @@
+// //////////////////////////////////////////////////////// GLSL version //
+#version 430 core
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/cubemap.glsl"
+
+// ///////////////////////////////////////////////////////// Work group //
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// /////////////////////////////////////////////////////////// Constants //
+const float PI = 3.14159265359;
+const float SAMPLE_DELTA = 0.05;
+
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform samplerCube texEnvironment;
+uniform int size;
+
+layout(rgba16f, binding = 0) uniform writeonly imageCube irradiance;
+
+// //////////////////////////////////////////////////////////////// Main //
+// Cosine-weighted integral of the environment over the hemisphere
+void main() {
+    ivec3 texel = ivec3(gl_GlobalInvocationID);
+    if (texel.x >= size || texel.y >= size) {
+        return;
+    }
+
+    vec3 normal = cubemapDirection(texel, size);
+    vec3 up = abs(normal.y) < 0.999 ? vec3(0.0, 1.0, 0.0)
+                                    : vec3(0.0, 0.0, 1.0);
+    vec3 right = normalize(cross(up, normal));
+    up = cross(normal, right);
+
+    vec3 sum = vec3(0.0);
+    float count = 0.0;
+    for (float phi = 0.0; phi < 2.0 * PI; phi += SAMPLE_DELTA) {
+        for (float theta = 0.0; theta < 0.5 * PI; theta += SAMPLE_DELTA) {
+            vec3 tangentSample = vec3(sin(theta) * cos(phi),
+                                      sin(theta) * sin(phi),
+                                      cos(theta));
+            vec3 direction = tangentSample.x * right +
+                             tangentSample.y * up +
+                             tangentSample.z * normal;
+
+            // A blurry level is enough and keeps the sum from aliasing
+            sum += sampleEnvironment(texEnvironment, direction, 4.0) *
+                   cos(theta) * sin(theta);
+            count += 1.0;
+        }
+    }
+
+    imageStore(irradiance, texel, vec4(PI * sum / count, 1.0));
+}
+
+// ///////////////////////////////////////////////////////////////////// //
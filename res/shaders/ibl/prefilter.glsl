@@ -0,0 +1,69 @@
+// //////////////////////////////////////////////////////// GLSL version //
+#version 430 core
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/cubemap.glsl"
+#include "../include/importance-sampling.glsl"
+
+// ///////////////////////////////////////////////////////// Work group //
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// /////////////////////////////////////////////////////////// Constants //
+const uint SAMPLE_COUNT = 512u;
+
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform samplerCube texEnvironment;
+uniform float environmentSize;
+uniform float roughness;
+uniform int size;
+
+layout(rgba16f, binding = 0) uniform writeonly imageCube prefiltered;
+
+// //////////////////////////////////////////////////////////////// Main //
+// Split-sum prefiltering, assuming the view direction equals the normal
+void main() {
+    ivec3 texel = ivec3(gl_GlobalInvocationID);
+    if (texel.x >= size || texel.y >= size) {
+        return;
+    }
+
+    vec3 normal = cubemapDirection(texel, size);
+
+    // The first level is a mirror
+    if (roughness == 0.0) {
+        imageStore(prefiltered, texel,
+                   vec4(sampleEnvironment(texEnvironment, normal, 0.0), 1.0));
+        return;
+    }
+
+    float a = roughness * roughness;
+    float texelSolidAngle = 4.0 * PI /
+                            (6.0 * environmentSize * environmentSize);
+
+    vec3 sum = vec3(0.0);
+    float weight = 0.0;
+    for (uint i = 0u; i < SAMPLE_COUNT; ++i) {
+        vec3 h = importanceSampleGGX(hammersley(i, SAMPLE_COUNT), normal,
+                                     roughness);
+        vec3 l = normalize(2.0 * dot(normal, h) * h - normal);
+
+        float nDotL = dot(normal, l);
+        if (nDotL <= 0.0) {
+            continue;
+        }
+
+        // Sample the level whose texels cover the sample's solid angle
+        float nDotH = max(dot(normal, h), 0.0);
+        float d = a * a / (PI * pow(nDotH * nDotH * (a * a - 1.0) + 1.0, 2.0));
+        float pdf = d / 4.0;
+        float sampleSolidAngle = 1.0 / (float(SAMPLE_COUNT) * pdf + 0.0001);
+        float lod = 0.5 * log2(sampleSolidAngle / texelSolidAngle) + 1.0;
+
+        sum += sampleEnvironment(texEnvironment, l, max(lod, 0.0)) * nDotL;
+        weight += nDotL;
+    }
+
+    imageStore(prefiltered, texel, vec4(sum / weight, 1.0));
+}
+
+// ///////////////////////////////////////////////////////////////////// //
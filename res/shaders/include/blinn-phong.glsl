@@ -0,0 +1,24 @@
+// /////////////////////////////////////////////// Lambert + Blinn-Phong //
+vec3 lambertBlinnPhong(LightParameters light, vec3 lightDir, float factor,
+                       vec3 normal, vec3 viewDir) {
+    // Ambient
+    float ambientFactor = 1.0;
+    vec3 ambient = ambientFactor * light.ambientIntensity * light.ambientColor;
+
+    // Diffuse
+    float diffuseFactor = clamp(dot(lightDir, normal), 0.0, 1.0);
+    vec3 diffuse = diffuseFactor * light.diffuseIntensity * light.diffuseColor;
+
+    // Specular
+    float specularFactor = pow(
+                            clamp(dot(normal,
+                                normalize(lightDir + viewDir)),     // Half
+                            0.0, 1.0),
+                            light.specularShininess);
+    vec3 specular = specularFactor * light.specularIntensity * light.specularColor;
+
+    // Final lighting
+    return factor * (ambient + diffuse + specular);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,63 @@
+// //////////////////////////////////////////////////////// Cluster grid //
+// CLUSTER_GRID_X/Y/Z and CLUSTER_MAX_LIGHTS are defined by LightClusters
+const uint CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+// //////////////////////////////////////////////////// Cluster light //
+struct ClusterLight {
+    vec4 position;      // xyz, w: range of influence
+    vec4 direction;     // xyz, w: spot angle, negative for point lights
+    vec4 attenuation;   // constant, linear, quadratic, enable
+    vec4 ambient;       // rgb, intensity
+    vec4 diffuse;       // rgb, intensity
+    vec4 specular;      // rgb, intensity
+    vec4 shininess;     // x: specular shininess
+};
+
+// ///////////////////////////////////////////////////////////// Buffers //
+layout(std430, binding = 0) buffer ClusterLights {
+    ClusterLight clusterLights[];
+};
+layout(std430, binding = 1) buffer ClusterLightCounts {
+    uint clusterLightCounts[CLUSTER_COUNT];
+};
+layout(std430, binding = 2) buffer ClusterLightIndices {
+    uint clusterLightIndices[CLUSTER_COUNT * CLUSTER_MAX_LIGHTS];
+};
+
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform vec2 clusterDepthRange;     // near, far
+uniform vec2 clusterTileSize;       // pixels
+
+// ///////////////////////////////////////////////////////////// Slicing //
+// Depth slices are spaced exponentially, so that clusters stay roughly
+// cubic in view space
+float clusterSliceDepth(float slice) {
+    return clusterDepthRange.x *
+           pow(clusterDepthRange.y / clusterDepthRange.x,
+               slice / float(CLUSTER_GRID_Z));
+}
+
+uint clusterSlice(float viewDepth) {
+    float slice = log(viewDepth / clusterDepthRange.x) /
+                  log(clusterDepthRange.y / clusterDepthRange.x) *
+                  float(CLUSTER_GRID_Z);
+    return uint(clamp(slice, 0.0, float(CLUSTER_GRID_Z - 1)));
+}
+
+uint clusterIndex(uvec3 cluster) {
+    return cluster.x +
+           CLUSTER_GRID_X * (cluster.y + CLUSTER_GRID_Y * cluster.z);
+}
+
+// Cluster of a fragment, from its window position and depth buffer value
+uint clusterIndex(vec4 fragCoord) {
+    float zNdc = 2.0 * fragCoord.z - 1.0;
+    float near = clusterDepthRange.x, far = clusterDepthRange.y;
+    float viewDepth = 2.0 * near * far / (far + near - zNdc * (far - near));
+
+    uvec2 tile = min(uvec2(fragCoord.xy / clusterTileSize),
+                     uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+    return clusterIndex(uvec3(tile, clusterSlice(viewDepth)));
+}
+
+// ///////////////////////////////////////////////////////////////////// //
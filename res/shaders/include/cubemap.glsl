@@ -0,0 +1,21 @@
+// ////////////////////////////////////////////////////// Cubemap faces //
+// Direction through a texel of a cubemap face, matching the face order
+// and orientation of GL_TEXTURE_CUBE_MAP_POSITIVE_X and onwards
+vec3 cubemapDirection(ivec3 texel, int size) {
+    vec2 uv = (vec2(texel.xy) + 0.5) / float(size) * 2.0 - 1.0;
+    switch (texel.z) {
+        case 0: return normalize(vec3(1.0, -uv.y, -uv.x));
+        case 1: return normalize(vec3(-1.0, -uv.y, uv.x));
+        case 2: return normalize(vec3(uv.x, 1.0, uv.y));
+        case 3: return normalize(vec3(uv.x, -1.0, -uv.y));
+        case 4: return normalize(vec3(uv.x, -uv.y, 1.0));
+        default: return normalize(vec3(-uv.x, -uv.y, -1.0));
+    }
+}
+
+// The skybox is stored in an sRGB format, so it samples as linear
+vec3 sampleEnvironment(samplerCube environment, vec3 direction, float lod) {
+    return textureLod(environment, direction, lod).rgb;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,24 @@
+// ///////////////////////////////////////////////////// Draw parameters //
+// Filled by DrawData, one entry per mesh instance
+struct DrawParameters {
+    mat4 world;
+    mat4 transform;
+    mat4 previousTransform;
+    uvec4 material;     // x: material table layer
+};
+
+// ///////////////////////////////////////////////////////////// Buffers //
+layout(std430, binding = 3) readonly buffer DrawData {
+    DrawParameters draws[];
+};
+
+// //////////////////////////////////////////////////////////// Uniforms //
+// Entry of the draw's first instance
+uniform int firstDraw;
+
+// Parameters of the instance being drawn
+DrawParameters drawParameters() {
+    return draws[firstDraw + gl_InstanceID];
+}
+
+// ///////////////////////////////////////////////////////////////////// //
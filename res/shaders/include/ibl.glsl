@@ -0,0 +1,38 @@
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform samplerCube texIrradiance;
+uniform samplerCube texPrefiltered;
+uniform sampler2D texBrdfLut;
+
+// //////////////////////////////////////////////// Image-based lighting //
+// Prefiltered environment in the direction of a reflection or
+// refraction, blurred by the surface roughness
+vec3 environmentRadiance(vec3 direction, float roughness) {
+    float lod = roughness * float(textureQueryLevels(texPrefiltered) - 1);
+    return textureLod(texPrefiltered, direction, lod).rgb;
+}
+
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 f0, float roughness) {
+    return f0 + (max(vec3(1.0 - roughness), f0) - f0) *
+                pow(1.0 - cosTheta, 5.0);
+}
+
+// Ambient term of the Cook-Torrance model: irradiance for the diffuse
+// part, split-sum approximation for the specular part
+vec3 ambientPbr(vec3 normal, vec3 viewDir,
+                vec3 albedo, float metalness, float roughness) {
+    float nDotV = max(dot(normal, viewDir), 0.0);
+    vec3 f = fresnelSchlickRoughness(nDotV,
+                                     mix(vec3(0.04), albedo, metalness),
+                                     roughness);
+    vec3 kD = (vec3(1.0) - f) * (1.0 - metalness);
+
+    vec3 diffuse = texture(texIrradiance, normal).rgb * albedo;
+
+    vec2 brdf = texture(texBrdfLut, vec2(nDotV, roughness)).rg;
+    vec3 specular = environmentRadiance(reflect(-viewDir, normal), roughness)
+                    * (f * brdf.x + brdf.y);
+
+    return kD * diffuse + specular;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,35 @@
+// //////////////////////////////////////////////////// Light parameters //
+struct LightParameters {
+    float enable;
+
+    vec3 direction;
+    vec3 position;
+    float angle;
+
+    float attenuationConstant;
+    float attenuationLinear;
+    float attenuationQuadratic;
+
+    float ambientIntensity;
+    vec3 ambientColor;
+    float diffuseIntensity;
+    vec3 diffuseColor;
+    float specularIntensity;
+    vec3 specularColor;
+    float specularShininess;
+};
+
+// ///////////////////////////////////////////////////////// Attenuation //
+float attenuate(LightParameters light, float distance) {
+    return 1.0 / (light.attenuationConstant
+                  + light.attenuationLinear * distance
+                  + light.attenuationQuadratic * pow(distance, 2));
+}
+
+float spotFactor(LightParameters light, vec3 lightDir) {
+    float spotCosAngle = dot(lightDir, -normalize(light.direction));
+    return max(spotCosAngle - cos(light.angle), 0.0)
+           / (1.0 - cos(light.angle));
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,10 @@
+// ////////////////////////////////////////////////////// Normal mapping //
+// MikkTSpace tangent frame: w of the tangent is the bitangent's sign
+vec3 calculateMappedNormal(vec3 normal, vec4 tangent, vec3 normalSample) {
+    vec3 t = normalize(tangent.xyz - dot(tangent.xyz, normal) * normal);
+    vec3 bitangent = tangent.w * cross(normal, t);
+    return normalize(mat3(t, bitangent, normal)
+                     * (2.0 * normalSample - vec3(1.0)));
+}
+
+// ///////////////////////////////////////////////////////////////////// //
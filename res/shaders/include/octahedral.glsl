@@ -0,0 +1,10 @@
+// ////////////////////////////////////////////////// Octahedral vectors //
+// Inverse of the encoding in mesh.cpp: unfold the lower half of the
+// octahedron from the corners of the [-1, 1] square
+vec3 decodeOctahedral(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
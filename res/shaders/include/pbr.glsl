@@ -0,0 +1,44 @@
+// /////////////////////////////////////////////////////////// Constants //
+const float PI = 3.14159265359;
+
+// //////////////////////////////////////////// Physical Based Rendering //
+float distributionGGX(vec3 n, vec3 h, float roughness) {
+    float a = pow(roughness, 4);
+    return a / (PI * pow(pow(max(dot(n, h), 0.0), 2) * (a - 1.0) + 1.0, 2));
+}
+float geometrySchlickGGX(float nDotV, float roughness) {
+    float k = pow((roughness + 1.0), 2) / 8.0;
+    return nDotV / (nDotV * (1.0 - k) + k);
+}
+float geometrySmith(vec3 n, vec3 v, vec3 l, float roughness) {
+    return geometrySchlickGGX(max(dot(n, l), 0.0), roughness) *
+           geometrySchlickGGX(max(dot(n, v), 0.0), roughness);
+}
+vec3 fresnelSchlick(float cosTheta, vec3 f0) {
+    return f0 + (1.0 - f0) * pow(1.0 - cosTheta, 5.0);
+}
+vec3 pbr(LightParameters light, vec3 lightDir, float factor, vec3 normal,
+         vec3 viewDir, vec3 albedo, float metalness, float roughness) {
+    // Radiance
+    vec3 h = normalize(viewDir + lightDir);
+    vec3 radiance = light.diffuseColor * factor;
+
+    // Cook-Torrance BRDF
+    float ndf = distributionGGX(normal, h, roughness);
+    float g = geometrySmith(normal, viewDir, lightDir, roughness);
+    vec3 f = fresnelSchlick(max(dot(h, viewDir), 0.0),
+                    mix(vec3(0.04), albedo, metalness));
+
+    vec3 kD = (vec3(1.0) - f) * (1.0 - metalness);
+
+    vec3 specular = (ndf * g * f) /
+            max((4.0 *
+                 max(dot(normal, viewDir), 0.0) *
+                 max(dot(normal, lightDir), 0.0)), 0.001);
+
+    return (kD * albedo / PI + specular) *
+           radiance *
+           max(dot(normal, lightDir), 0.0);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
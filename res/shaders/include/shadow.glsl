@@ -0,0 +1,28 @@
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform sampler2D texShadow;
+
+// ////////////////////////////////////////////////////// Shadow mapping //
+float calculateShadow(vec3 positionLightSpace, vec3 normal,
+                      vec3 lightDirection) {
+    vec3 projectedCoordinates = positionLightSpace * 0.5 + 0.5;
+
+    if (projectedCoordinates.z > 1.0) {
+        return 0.0;
+    }
+
+    float currentDepth = projectedCoordinates.z;
+
+    float bias = max(0.025 * (1.0 - dot(-normal, lightDirection)), 0.005);
+
+    float shadow = 0.0;
+    vec2 texelSize = 1.0 / textureSize(texShadow, 0);
+    for (int x = -1; x <= 1; ++x) {
+        for (int y = -1; y <= 1; ++y) {
+            float pcfDepth = texture(texShadow, projectedCoordinates.xy + vec2(x, y) * texelSize).r;
+            shadow += ((currentDepth - bias) > pcfDepth ? 0.75 : 0.0);
+        }
+    }
+    return (shadow / 9.0);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
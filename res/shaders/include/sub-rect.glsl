@@ -0,0 +1,10 @@
+// ////////////////////////////////////////////////////////// Sub-rects //
+// Post-processing targets are allocated for the largest render scale and
+// a frame covers only their lower-left corner. Samples that corner with a
+// [0, 1] coordinate, half a texel inside so bilinear taps never read the
+// stale texels beyond it.
+vec4 textureSubRect(sampler2D source, vec2 texCoords, vec2 scale) {
+    vec2 halfTexel = 0.5 / vec2(textureSize(source, 0));
+    return texture(source,
+                   clamp(texCoords * scale, halfTexel, scale - halfTexel));
+}
@@ -0,0 +1,10 @@
+// //////////////////////////////////////////////////////////// Velocity //
+// Screen-space motion since the previous frame in texture coordinates,
+// without the sub-pixel jitter of either frame
+vec2 calculateVelocity(vec4 clipPosition, vec4 previousClipPosition,
+                       vec2 jitter, vec2 previousJitter) {
+    vec2 current = clipPosition.xy / clipPosition.w - jitter;
+    vec2 previous = previousClipPosition.xy / previousClipPosition.w -
+                    previousJitter;
+    return 0.5 * (current - previous);
+}
@@ -1,241 +1,195 @@
 // //////////////////////////////////////////////////////// GLSL version //
 #version 430 core
 
-// /////////////////////////////////////////////////////////// Constants //
-const float PI = 3.14159265359;
+// ///////////////////////////////////////////////////////// Permutation //
+// Lighting:  LIGHTING_PBR or LIGHTING_LBP
+// Surface:   SURFACE_OPAQUE, SURFACE_REFLECT or SURFACE_REFRACT
+// Shadows:   SHADOWS 0 or 1
+// Lights:    CLUSTERED_LIGHTS 0 or 1, for point and spot lights
+#if !defined(LIGHTING_PBR) && !defined(LIGHTING_LBP)
+#define LIGHTING_PBR 1
+#endif
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+#ifndef CLUSTERED_LIGHTS
+#define CLUSTERED_LIGHTS 0
+#endif
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/lights.glsl"
+#include "../include/normal-mapping.glsl"
+#include "../include/ibl.glsl"
+#include "../include/velocity.glsl"
+#if CLUSTERED_LIGHTS
+#include "../include/clusters.glsl"
+#endif
+#if SHADOWS
+#include "../include/shadow.glsl"
+#endif
+#if defined(LIGHTING_PBR)
+#include "../include/pbr.glsl"
+#else
+#include "../include/blinn-phong.glsl"
+#endif
 
 // ////////////////////////////////////////////////////////////// Inputs //
 in vec3 fPosition;
 in vec3 fPositionLightSpace;
 in vec3 fNormal;
 in vec2 fTexCoords;
-in vec3 fTangent;
+in vec4 fTangent;
+in vec4 fClipPosition;
+in vec4 fPreviousClipPosition;
+flat in uint fMaterial;
 
 // ///////////////////////////////////////////////////////////// Outputs //
-out vec4 outColor;
-
-// //////////////////////////////////////////////////// Light parameters //
-struct LightParameters {
-//    float enable;
-
-    vec3 direction;
-//    vec3 position;
-//    float angle;
-//
-//    float attenuationConstant;
-//    float attenuationLinear;
-//    float attenuationQuadratic;
-//
-//    float ambientIntensity;
-//    vec3 ambientColor;
-//    float diffuseIntensity;
-    vec3 diffuseColor;
-//    float specularIntensity;
-//    vec3 specularColor;
-//    float specularShininess;
-};
+layout (location = 0) out vec4 outColor;
+layout (location = 1) out vec2 outVelocity;
 
 // //////////////////////////////////////////////////////////// Uniforms //
-//uniform bool pbrEnabled;
-
-uniform bool reflectOverride;
-uniform bool refractOverride;
-
-uniform samplerCube texSkybox;
-uniform sampler2D texShadow;
-uniform sampler2D texAo;
-uniform sampler2D texAlbedo;
-uniform sampler2D texMetalness;
-uniform sampler2D texRoughness;
-uniform sampler2D texNormal;
+// Material table, one layer per material
+uniform sampler2DArray texAlbedo;
+// Occlusion, roughness and metalness in red, green and blue
+uniform sampler2DArray texOrm;
+uniform sampler2DArray texNormal;
 
 uniform vec3 viewPos;
 uniform mat4 world;
 
-uniform LightParameters lightDirectional;
-//uniform LightParameters lightPoint;
-//uniform LightParameters lightSpot1;
-//uniform LightParameters lightSpot2;
-
-// ////////////////////////////////////////////////////// Shadow mapping //
-float calculateShadow(vec3 normal)
-{
-    vec3 projectedCoordinates = fPositionLightSpace * 0.5 + 0.5;
+uniform vec2 jitter;
+uniform vec2 previousJitter;
 
-    if (projectedCoordinates.z > 1.0) {
-        return 0.0;
-    }
-
-    float closestDepth = texture(texShadow, projectedCoordinates.xy).r;
-    float currentDepth = projectedCoordinates.z;
-
-    float bias = max(0.025 * (1.0 - dot(-normal, lightDirectional.direction)), 0.005);
+uniform LightParameters lightDirectional;
 
-    float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(texShadow, 0);
-    for (int x = -1; x <= 1; ++x) {
-        for (int y = -1; y <= 1; ++y) {
-            float pcfDepth = texture(texShadow, projectedCoordinates.xy + vec2(x, y) * texelSize).r;
-            shadow += ((currentDepth - bias) > pcfDepth ? 0.75 : 0.0);
-        }
-    }
-    return (shadow / 9.0);
+// //////////////////////////////////////////////////////////// Lighting //
+vec3 albedo;
+float metalness;
+float roughness;
+
+vec3 shade(LightParameters light, vec3 lightDir, float factor,
+           vec3 normal, vec3 viewDir) {
+#if defined(LIGHTING_PBR)
+    return pbr(light, lightDir, factor, normal, viewDir,
+               albedo, metalness, roughness);
+#else
+    return lambertBlinnPhong(light, lightDir, factor, normal, viewDir);
+#endif
 }
 
-// ////////////////////////////////////////////////////// Normal mapping //
-vec3 calculateMappedNormal() {
-    vec3 tangent = normalize(fTangent - dot(fTangent, fNormal) * fNormal);
-    return normalize(mat3(tangent, cross(tangent, fNormal), fNormal)
-                     * (2.0 * texture(texNormal, fTexCoords).xyz
-                        - vec3(1.0)));
+vec3 directional(LightParameters light, vec3 normal, vec3 viewDir) {
+    return shade(light, -normalize(light.direction), 1.0, normal, viewDir);
 }
 
-// /////////////////////////////////////////////// Lambert + Blinn-Phong //
-//vec4 lambertBlinnPhong(LightParameters light, vec3 lightDir, float factor) {
-//    vec3 normal = calculateMappedNormal();
-//
-//    // Ambient
-//    float ambientFactor = 1.0;
-//    vec3 ambient = ambientFactor * light.ambientIntensity * light.ambientColor;
-//
-//    // Diffuse
-//    float diffuseFactor = clamp(dot(lightDir, normal), 0.0, 1.0);
-//    vec3 diffuse = diffuseFactor * light.diffuseIntensity * light.diffuseColor;
-//
-//    // Specular
-//    float specularFactor = pow(
-//                            clamp(dot(normal,
-//                                normalize(lightDir +                // Half
-//                                normalize(viewPos - fPosition))),   // View
-//                            0.0, 1.0),
-//                            light.specularShininess);
-//    vec3 specular = specularFactor * light.specularIntensity * light.specularColor;
-//
-//    // Final lighting
-//    return factor * vec4(ambient + diffuse + specular, 1.0);
-//}
-//
-// //////////////////////////////////////////// Physical Based Rendering //
-float distributionGGX(vec3 n, vec3 h, float roughness) {
-    float a = pow(roughness, 4);
-    return a / (PI * pow(pow(max(dot(n, h), 0.0), 2) * (a - 1.0) + 1.0, 2));
-}
-float geometrySchlickGGX(float nDotV, float roughness) {
-    float k = pow((roughness + 1.0), 2) / 8.0;
-    return nDotV / (nDotV * (1.0 - k) + k);
-}
-float geometrySmith(vec3 n, vec3 v, vec3 l, float roughness) {
-    return geometrySchlickGGX(max(dot(n, l), 0.0), roughness) *
-           geometrySchlickGGX(max(dot(n, v), 0.0), roughness);
+vec3 point(LightParameters light, vec3 normal, vec3 viewDir) {
+    vec3 lightDir = normalize(light.position - fPosition);
+    return shade(light, lightDir,
+                 light.enable *
+                 attenuate(light, length(light.position - fPosition)),
+                 normal, viewDir);
 }
-vec3 fresnelSchlick(float cosTheta, vec3 f0) {
-    return f0 + (1.0 - f0) * pow(1.0 - cosTheta, 5.0);
-}
-vec4 pbr(LightParameters light, vec3 lightDir, float factor, vec3 normal) {
-    // Load texture parameters
-    vec3 albedo = pow(texture(texAlbedo, fTexCoords).rgb, vec3(2.2));
-//    vec3 normal = calculateMappedNormal();
-    float metalness = texture(texMetalness, fTexCoords).r;
-    float roughness = texture(texRoughness, fTexCoords).r;
-    float ao = texture(texAo, fTexCoords).r;
 
-    // Calculate view direction
-    vec3 viewDir = normalize(viewPos - fPosition);
-
-    // Radiance
-    vec3 h = normalize(viewDir + lightDir);
-    vec3 radiance = light.diffuseColor * factor;
-
-    // Cook-Torrance BRDF
-    float ndf = distributionGGX(normal, h, roughness);
-    float g = geometrySmith(normal, viewDir, lightDir, roughness);
-    vec3 f = fresnelSchlick(max(dot(h, viewDir), 0.0),
-                    mix(vec3(0.04), albedo, metalness));
-
-    vec3 kD = (vec3(1.0) - f) * (1.0 - metalness);
-
-    vec3 specular = (ndf * g * f) /
-            max((4.0 *
-                 max(dot(normal, viewDir), 0.0) *
-                 max(dot(normal, lightDir), 0.0)), 0.001);
-
-    return vec4((kD * albedo / PI + specular) *
-                radiance *
-                max(dot(normal, lightDir), 0.0), 1.0);
+vec3 spot(LightParameters light, vec3 normal, vec3 viewDir) {
+    vec3 lightDir = normalize(light.position - fPosition);
+    return shade(light, lightDir,
+                 light.enable * spotFactor(light, lightDir) *
+                 attenuate(light, length(light.position - fPosition)),
+                 normal, viewDir);
 }
 
-// ///////////////////////////////////////////////////////// Light types //
-//float attenuate(LightParameters light, float distance) {
-//    return 1.0 / (light.attenuationConstant
-//                  + light.attenuationLinear * distance
-//                  + light.attenuationQuadratic * pow(distance, 2));
-//}
-
-vec4 directional(LightParameters light, vec3 normal) {
-//    if (pbrEnabled) {
-    return pbr(light, -normalize(light.direction), 1.0, normal);
-//    }
-//    return lambertBlinnPhong(light, -normalize(light.direction), 1.0);
+#if CLUSTERED_LIGHTS
+LightParameters unpack(ClusterLight light) {
+    return LightParameters(light.attenuation.w,
+                           light.direction.xyz,
+                           light.position.xyz,
+                           light.direction.w,
+                           light.attenuation.x,
+                           light.attenuation.y,
+                           light.attenuation.z,
+                           light.ambient.w,
+                           light.ambient.rgb,
+                           light.diffuse.w,
+                           light.diffuse.rgb,
+                           light.specular.w,
+                           light.specular.rgb,
+                           light.shininess.x);
 }
 
-//vec4 point(LightParameters light) {
-//    vec3 lightDir = normalize(light.position - fPosition);
-//    if (pbrEnabled) {
-//        return pbr(light, lightDir,
-//                   attenuate(light, length(light.position - fPosition)));
-//    }
-//    return lambertBlinnPhong(light, lightDir,
-//                    attenuate(light, length(light.position - fPosition)));
-//}
-//
-//vec4 spot(LightParameters light) {
-//    vec3 lightDir = normalize(light.position - fPosition);
-//    float spotCosAngle = dot(lightDir, -normalize(light.direction));
-//    if (spotCosAngle < cos(light.angle)) {
-//        return vec4(0);
-//    }
-//
-//    if (pbrEnabled) {
-//        return pbr(light, lightDir,
-//            (spotCosAngle - cos(light.angle)) / (1.0 - cos(light.angle))
-//                * attenuate(light, length(light.position - fPosition)));
-//    }
-//    return lambertBlinnPhong(light, lightDir,
-//        (spotCosAngle - cos(light.angle)) / (1.0 - cos(light.angle))
-//            * attenuate(light, length(light.position - fPosition)));
-//}
+// Point and spot lights whose range touches this fragment's cluster
+vec3 clustered(vec3 normal, vec3 viewDir) {
+    uint cluster = clusterIndex(gl_FragCoord);
+    uint count = min(clusterLightCounts[cluster], uint(CLUSTER_MAX_LIGHTS));
+
+    vec3 color = vec3(0.0);
+    for (uint i = 0u; i < count; ++i) {
+        LightParameters light = unpack(clusterLights[
+                clusterLightIndices[cluster * CLUSTER_MAX_LIGHTS + i]]);
+        color += light.angle < 0.0 ? point(light, normal, viewDir)
+                                   : spot(light, normal, viewDir);
+    }
+    return color;
+}
+#endif
 
 // //////////////////////////////////////////////////////////////// Main //
 void main() {
-    // Final pixel color
-    vec3 normal = calculateMappedNormal();
+    vec3 materialCoords = vec3(fTexCoords, float(fMaterial));
+    outVelocity = calculateVelocity(fClipPosition, fPreviousClipPosition,
+                                    jitter, previousJitter);
+
+    vec3 normal = calculateMappedNormal(fNormal, fTangent,
+                                        texture(texNormal, materialCoords).xyz);
+
+#if defined(SURFACE_REFLECT) || defined(SURFACE_REFRACT)
+    vec3 incident = normalize(fPosition - viewPos);
+#if defined(SURFACE_REFLECT)
+    vec3 direction = reflect(incident, normal);
+#else
+    vec3 direction = refract(incident, normal, 1.0 / 1.52);
+#endif
+    vec3 radiance = environmentRadiance(
+            direction, texture(texOrm, materialCoords).g);
+    outColor = vec4(radiance, 1.0);
+#else
+    // Load texture parameters, albedo is decoded from sRGB when sampled
+    albedo = texture(texAlbedo, materialCoords).rgb;
+    vec3 orm = texture(texOrm, materialCoords).rgb;
+    float ao = orm.r;
+    roughness = orm.g;
+    metalness = orm.b;
 
-    outColor = clamp(directional(lightDirectional, normal),// * lightDirectional.enable,
-//                    + point(lightPoint) * lightPoint.enable
-//                    + spot(lightSpot1) * lightSpot1.enable
-//                    + spot(lightSpot2) * lightSpot2.enable,
-                        vec4(0.0), vec4(1.0));
-
-    vec4 pixelColor = vec4(texture(texAo, fTexCoords).rgb * outColor.rgb, 1.0);
+    // Calculate view direction
+    vec3 viewDir = normalize(viewPos - fPosition);
 
-    if (reflectOverride) {
-        outColor = vec4(texture(texSkybox,
-                reflect(normalize(fPosition - viewPos), normal)).rgb, 1.0);
-    }
-    else if (refractOverride) {
-        float alpha = 1.0 / 1.52;
-        outColor = vec4(texture(texSkybox,
-                refract(normalize(fPosition - viewPos), normal, alpha)).rgb, 1.0);
-    }
-    else {
-//        if (pbrEnabled) {
-        outColor = pow(pixelColor, vec4(1.0 / 2.2)) * (1.0 - calculateShadow(normal));
-//        }
-//        else {
-//            outColor = pow(pixelColor * pow(texture(texAlbedo, fTexCoords), vec4(2.2)),
-//            vec4(1.0 / 2.2));
-//        }
-    }
+#if SHADOWS
+    float shadow = calculateShadow(fPositionLightSpace, normal,
+                                   lightDirectional.direction);
+#else
+    float shadow = 0.0;
+#endif
+
+#if defined(LIGHTING_PBR)
+    // Shadows block the sun only, occlusion darkens the environment only
+    vec3 color = (1.0 - shadow) * directional(lightDirectional, normal,
+                                              viewDir);
+#if CLUSTERED_LIGHTS
+    color += clustered(normal, viewDir);
+#endif
+    color += ao * ambientPbr(normal, viewDir, albedo, metalness, roughness);
+
+    // Final pixel color, linear HDR, tonemapped in post-processing
+    outColor = vec4(color, 1.0);
+#else
+    vec3 color = directional(lightDirectional, normal, viewDir);
+#if CLUSTERED_LIGHTS
+    color += clustered(normal, viewDir);
+#endif
+
+    // Final pixel color, linear HDR, tonemapped in post-processing
+    outColor = vec4(ao * clamp(color, vec3(0.0), vec3(1.0)) * albedo *
+                    (1.0 - shadow), 1.0);
+#endif
+#endif
 }
 
 // ///////////////////////////////////////////////////////////////////// //
@@ -10,14 +10,20 @@ in vec3 gPosition[3];
 in vec3 gPositionLightSpace[3];
 in vec3 gNormal[3];
 in vec2 gTexCoords[3];
-in vec3 gTangent[3];
+in vec4 gTangent[3];
+in vec4 gClipPosition[3];
+in vec4 gPreviousClipPosition[3];
+flat in uint gMaterial[3];
 
 // ///////////////////////////////////////////////////////////// Outputs //
 out vec3 fPosition;
 out vec3 fPositionLightSpace;
 out vec3 fNormal;
 out vec2 fTexCoords;
-out vec3 fTangent;
+out vec4 fTangent;
+out vec4 fClipPosition;
+out vec4 fPreviousClipPosition;
+flat out uint fMaterial;
 
 // //////////////////////////////////////////////////////////////// Main //
 void main() {
@@ -27,6 +33,9 @@ void main() {
         fNormal = gNormal[i];
         fTexCoords = gTexCoords[i];
         fTangent = gTangent[i];
+        fClipPosition = gClipPosition[i];
+        fPreviousClipPosition = gPreviousClipPosition[i];
+        fMaterial = gMaterial[i];
 
         gl_Position = gl_in[i].gl_Position;
         EmitVertex();
@@ -1,27 +1,51 @@
 // //////////////////////////////////////////////////////// GLSL version //
 #version 430 core
 
+// ///////////////////////////////////////////////////////// Permutation //
+// Vertices: QUANTIZED_VERTICES 0 or 1, for the PackedVertex layout
+#ifndef QUANTIZED_VERTICES
+#define QUANTIZED_VERTICES 0
+#endif
+
 // ////////////////////////////////////////////////////////////// Inputs //
+#if QUANTIZED_VERTICES
+layout (location = 0) in vec4 vPosition;
+layout (location = 1) in vec2 vNormal;
+layout (location = 2) in vec2 vTexCoords;
+layout (location = 3) in vec2 vTangent;
+#else
 layout (location = 0) in vec3 vPosition;
 layout (location = 1) in vec3 vNormal;
 layout (location = 2) in vec2 vTexCoords;
-layout (location = 3) in vec3 vTangent;
+layout (location = 3) in vec4 vTangent;
+#endif
 
 // ///////////////////////////////////////////////////////////// Outputs //
 out vec3 gPosition;
 out vec3 gPositionLightSpace;
 out vec3 gNormal;
 out vec2 gTexCoords;
-out vec3 gTangent;
+out vec4 gTangent;
+out vec4 gClipPosition;
+out vec4 gPreviousClipPosition;
+flat out uint gMaterial;
 
 // //////////////////////////////////////////////////////////// Uniforms //
-uniform mat4 world;
-uniform mat4 transform;
 uniform mat4 lightSpaceTransform;
 
 uniform int instances;
 uniform vec3 offset;
 
+// Bounding box of the mesh, for quantized positions
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/draw-data.glsl"
+#if QUANTIZED_VERTICES
+#include "../include/octahedral.glsl"
+#endif
+
 // /////////////////////////////////////////////// Instance translations //
 vec3 translations[25];
 void createTranslations() {
@@ -35,6 +59,17 @@ void createTranslations() {
 
 // //////////////////////////////////////////////////////////////// Main //
 void main() {
+    DrawParameters draw = drawParameters();
+#if QUANTIZED_VERTICES
+    vec3 position = positionOffset + positionScale * vPosition.xyz;
+    vec3 normal = decodeOctahedral(vNormal);
+    vec4 tangent = vec4(decodeOctahedral(vTangent), 2.0 * vPosition.w - 1.0);
+#else
+    vec3 position = vPosition;
+    vec3 normal = vNormal;
+    vec4 tangent = vTangent;
+#endif
+
     // If needed, translate instanced objects
 //    if (instances > 1) {
 //        createTranslations();
@@ -46,14 +81,17 @@ void main() {
 
     // Pass variables to geometry shader
 //    gPosition = (world * vec4(vPosition + translations[gl_InstanceID], 1.0)).xyz;
-    gPosition = (world * vec4(vPosition, 1.0)).xyz;
+    gPosition = (draw.world * vec4(position, 1.0)).xyz;
     gPositionLightSpace = (lightSpaceTransform * vec4(gPosition, 1.0)).xyz;
-    gNormal = normalize((/*world * */vec4(vNormal, 1.0)).xyz);
+    gNormal = normalize((/*world * */vec4(normal, 1.0)).xyz);
     gTexCoords = vTexCoords;
-    gTangent = normalize((/*world * */vec4(vTangent, 1.0)).xyz);
+    gTangent = vec4(normalize(tangent.xyz), tangent.w);
 
 //    gl_Position = transform * vec4(vPosition + translations[gl_InstanceID], 1.0);
-    gl_Position = transform * vec4(vPosition, 1.0);
+    gl_Position = draw.transform * vec4(position, 1.0);
+    gClipPosition = gl_Position;
+    gPreviousClipPosition = draw.previousTransform * vec4(position, 1.0);
+    gMaterial = draw.material.x;
 }
 
 // ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,37 @@
+// //////////////////////////////////////////////////////// GLSL version //
+#version 430 core
+
+// ////////////////////////////////////////////////////////////// Inputs //
+in vec2 fTexCoords;
+
+// ///////////////////////////////////////////////////////////// Outputs //
+out vec4 outColor;
+
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform sampler2D texSource;
+uniform vec2 texCoordScale;
+uniform vec2 texelStep;
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/sub-rect.glsl"
+
+// /////////////////////////////////////////////////////////// Constants //
+// 9-tap Gaussian folded into 5 bilinear fetches
+const float OFFSETS[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float WEIGHTS[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+// //////////////////////////////////////////////////////////////// Main //
+void main() {
+    vec3 color = textureSubRect(texSource, fTexCoords, texCoordScale).rgb *
+                 WEIGHTS[0];
+    for (int i = 1; i < 3; ++i) {
+        vec2 offset = OFFSETS[i] * texelStep;
+        color += textureSubRect(texSource, fTexCoords + offset,
+                                texCoordScale).rgb * WEIGHTS[i];
+        color += textureSubRect(texSource, fTexCoords - offset,
+                                texCoordScale).rgb * WEIGHTS[i];
+    }
+    outColor = vec4(color, 1.0);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
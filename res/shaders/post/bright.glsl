@@ -0,0 +1,33 @@
+// //////////////////////////////////////////////////////// GLSL version //
+#version 430 core
+
+// ////////////////////////////////////////////////////////////// Inputs //
+in vec2 fTexCoords;
+
+// ///////////////////////////////////////////////////////////// Outputs //
+out vec4 outColor;
+
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform sampler2D texScene;
+uniform vec2 texCoordScale;
+uniform float threshold;
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/sub-rect.glsl"
+
+// //////////////////////////////////////////////////////////////// Main //
+// Keeps what exceeds the threshold, with a soft knee below it
+void main() {
+    vec3 color = textureSubRect(texScene, fTexCoords, texCoordScale).rgb;
+    float brightness = max(color.r, max(color.g, color.b));
+
+    float knee = 0.5 * threshold;
+    float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee + 0.0001);
+
+    float contribution = max(soft, brightness - threshold) /
+                         max(brightness, 0.0001);
+    outColor = vec4(color * contribution, 1.0);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
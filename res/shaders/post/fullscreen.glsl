@@ -0,0 +1,15 @@
+// //////////////////////////////////////////////////////// GLSL version //
+#version 430 core
+
+// ///////////////////////////////////////////////////////////// Outputs //
+out vec2 fTexCoords;
+
+// //////////////////////////////////////////////////////////////// Main //
+// One triangle covering the viewport, without any vertex buffer
+void main() {
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    fTexCoords = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
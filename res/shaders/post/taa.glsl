@@ -0,0 +1,81 @@
+// //////////////////////////////////////////////////////// GLSL version //
+#version 430 core
+
+// ////////////////////////////////////////////////////////////// Inputs //
+in vec2 fTexCoords;
+
+// ///////////////////////////////////////////////////////////// Outputs //
+out vec4 outColor;
+
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform sampler2D texScene;
+uniform sampler2D texVelocity;
+uniform sampler2D texHistory;
+uniform vec2 texCoordScale;
+uniform vec2 historyTexCoordScale;
+
+// Share of the history in the result, 0 when there is none
+uniform float historyWeight;
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/sub-rect.glsl"
+
+// /////////////////////////////////////////////////////////////// YCoCg //
+// Clamping in YCoCg keeps the box tight around the luma axis
+vec3 rgbToYCoCg(vec3 color) {
+    return vec3(dot(color, vec3(0.25, 0.5, 0.25)),
+                dot(color, vec3(0.5, 0.0, -0.5)),
+                dot(color, vec3(-0.25, 0.5, -0.25)));
+}
+
+vec3 yCoCgToRgb(vec3 color) {
+    return vec3(color.x + color.y - color.z,
+                color.x + color.z,
+                color.x - color.y - color.z);
+}
+
+float luma(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// //////////////////////////////////////////////////////////////// Main //
+void main() {
+    // The pass runs at the scene's resolution, one fragment per texel
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 last = ivec2(texCoordScale * vec2(textureSize(texScene, 0)) +
+                       0.5) - 1;
+
+    vec3 current = texelFetch(texScene, pixel, 0).rgb;
+
+    // Colour range of the 3x3 neighbourhood
+    vec3 low = rgbToYCoCg(current);
+    vec3 high = low;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            ivec2 neighbour = clamp(pixel + ivec2(x, y), ivec2(0), last);
+            vec3 color = rgbToYCoCg(texelFetch(texScene, neighbour, 0).rgb);
+            low = min(low, color);
+            high = max(high, color);
+        }
+    }
+
+    // Reproject, and reject history the neighbourhood could not produce
+    vec2 previousCoords = fTexCoords - texelFetch(texVelocity, pixel, 0).xy;
+    vec3 history = textureSubRect(texHistory, previousCoords,
+                                  historyTexCoordScale).rgb;
+    history = yCoCgToRgb(clamp(rgbToYCoCg(history), low, high));
+
+    float weight = historyWeight;
+    if (any(lessThan(previousCoords, vec2(0.0))) ||
+        any(greaterThan(previousCoords, vec2(1.0)))) {
+        weight = 0.0;
+    }
+
+    // Weighting by inverse luma keeps bright HDR samples from flickering
+    float currentShare = (1.0 - weight) / (1.0 + luma(current));
+    float historyShare = weight / (1.0 + luma(history));
+    outColor = vec4((current * currentShare + history * historyShare) /
+                    (currentShare + historyShare), 1.0);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
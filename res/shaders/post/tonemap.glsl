@@ -0,0 +1,41 @@
+// //////////////////////////////////////////////////////// GLSL version //
+#version 430 core
+
+// ////////////////////////////////////////////////////////////// Inputs //
+in vec2 fTexCoords;
+
+// ///////////////////////////////////////////////////////////// Outputs //
+out vec4 outColor;
+
+// //////////////////////////////////////////////////////////// Uniforms //
+uniform sampler2D texScene;
+uniform sampler2D texBloom;
+uniform vec2 sceneTexCoordScale;
+uniform vec2 bloomTexCoordScale;
+uniform float exposure;
+uniform float bloomStrength;
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/sub-rect.glsl"
+
+// /////////////////////////////////////////////////////////// Tonemapping //
+// Narkowicz's fit of the ACES filmic curve
+vec3 tonemapAces(vec3 x) {
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14),
+                 0.0, 1.0);
+}
+
+// //////////////////////////////////////////////////////////////// Main //
+void main() {
+    // Bilinear upscale of the scene to the window's resolution
+    vec3 color = textureSubRect(texScene, fTexCoords,
+                                sceneTexCoordScale).rgb +
+                 bloomStrength * textureSubRect(texBloom, fTexCoords,
+                                                bloomTexCoordScale).rgb;
+
+    // Final pixel color
+    outColor = vec4(pow(tonemapAces(exposure * color), vec3(1.0 / 2.2)),
+                    1.0);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -3,17 +3,28 @@
 
 // ////////////////////////////////////////////////////////////// Inputs //
 in vec3 fTexCoords;
+in vec4 fClipPosition;
+in vec4 fPreviousClipPosition;
 
 // ///////////////////////////////////////////////////////////// Outputs //
-out vec4 outColor;
+layout (location = 0) out vec4 outColor;
+layout (location = 1) out vec2 outVelocity;
 
 // //////////////////////////////////////////////////////////// Uniforms //
 uniform samplerCube texSkybox;
 
+uniform vec2 jitter;
+uniform vec2 previousJitter;
+
+// //////////////////////////////////////////////////////////// Includes //
+#include "../include/velocity.glsl"
+
 // //////////////////////////////////////////////////////////////// Main //
 void main() {
-    // Final pixel color
-    outColor = texture(texSkybox, fTexCoords);
+    // Final pixel color, the sRGB cubemap samples as linear
+    outColor = vec4(texture(texSkybox, fTexCoords).rgb, 1.0);
+    outVelocity = calculateVelocity(fClipPosition, fPreviousClipPosition,
+                                    jitter, previousJitter);
 }
 
 // ///////////////////////////////////////////////////////////////////// //
@@ -7,14 +7,20 @@ layout (triangle_strip, max_vertices = 3) out;
 
 // ////////////////////////////////////////////////////////////// Inputs //
 in vec3 gTexCoords[3];
+in vec4 gClipPosition[3];
+in vec4 gPreviousClipPosition[3];
 
 // ///////////////////////////////////////////////////////////// Outputs //
 out vec3 fTexCoords;
+out vec4 fClipPosition;
+out vec4 fPreviousClipPosition;
 
 // //////////////////////////////////////////////////////////////// Main //
 void main() {
     for (int i = 0; i < gl_in.length(); ++i) {
         fTexCoords = gTexCoords[i];
+        fClipPosition = gClipPosition[i];
+        fPreviousClipPosition = gPreviousClipPosition[i];
 
         gl_Position = gl_in[i].gl_Position;
         EmitVertex();
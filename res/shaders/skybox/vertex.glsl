@@ -6,16 +6,22 @@ layout (location = 0) in vec3 vPosition;
 
 // ///////////////////////////////////////////////////////////// Outputs //
 out vec3 gTexCoords;
+out vec4 gClipPosition;
+out vec4 gPreviousClipPosition;
 
 // //////////////////////////////////////////////////////////// Uniforms //
 uniform mat4 world;
 uniform mat4 transform;
+uniform mat4 previousTransform;
 
 // //////////////////////////////////////////////////////////////// Main //
 void main() {
     gTexCoords = vPosition;
     vec4 position = transform * vec4(vPosition, 1.0);
     gl_Position = position.xyww;
+    gClipPosition = gl_Position;
+    gPreviousClipPosition =
+            (previousTransform * vec4(vPosition, 1.0)).xyww;
 }
 
 // ///////////////////////////////////////////////////////////////////// //
\ No newline at end of file
@@ -0,0 +1,150 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::ofstream;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+using glm::vec3;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    float const PI = 3.14159265359f;
+
+    // Length of one loop of the camera path, in seconds
+    float const CAMERA_LOOP = 20.0f;
+
+    float percentile(vector<float> values, float const p) {
+        if (values.empty()) {
+            return 0.0f;
+        }
+        std::sort(values.begin(), values.end());
+        return values[static_cast<size_t>(p * (values.size() - 1) + 0.5f)];
+    }
+
+    float average(vector<float> const &values) {
+        if (values.empty()) {
+            return 0.0f;
+        }
+        float sum = 0.0f;
+        for (float const value : values) {
+            sum += value;
+        }
+        return sum / values.size();
+    }
+
+    void writeTimings(ofstream &file, string const &name,
+                      vector<float> const &values) {
+        file << name << "_ms_avg," << average(values) << '\n'
+             << name << "_ms_p50," << percentile(values, 0.50f) << '\n'
+             << name << "_ms_p95," << percentile(values, 0.95f) << '\n'
+             << name << "_ms_p99," << percentile(values, 0.99f) << '\n';
+    }
+}
+
+// //////////////////////////////////////////////////// Class: Benchmark //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+Benchmark::Benchmark(BenchmarkSettings const &settings)
+        : settings(settings),
+          frame(0),
+          totals() {
+}
+
+bool Benchmark::finished() const {
+    return time() >= settings.duration;
+}
+
+float Benchmark::time() const {
+    return frame * TIMESTEP;
+}
+
+void Benchmark::advance() {
+    frame++;
+}
+
+vec3 Benchmark::cameraPosition() const {
+    // Orbit around the board, rising and falling twice per loop
+    float const angle = 2.0f * PI * time() / CAMERA_LOOP;
+    return vec3(40.0f * std::sin(angle),
+                35.0f + 15.0f * std::sin(2.0f * angle),
+                -40.0f * std::cos(angle));
+}
+
+vec3 Benchmark::cameraFront() const {
+    vec3 const toBoard = glm::normalize(-cameraPosition());
+
+    // Look away from the board for a quarter of each loop, so that
+    // culling and the empty-view path are part of the measurement
+    float const phase = std::fmod(time(), CAMERA_LOOP) / CAMERA_LOOP;
+    float const away = glm::smoothstep(0.55f, 0.6f, phase) *
+                       (1.0f - glm::smoothstep(0.8f, 0.85f, phase));
+
+    return glm::normalize(glm::mix(toBoard,
+                                   glm::normalize(vec3(toBoard.x, 1.0f,
+                                                       toBoard.z)),
+                                   away));
+}
+
+float Benchmark::paletteOffset(float const halfWidth) const {
+    return 0.5f * halfWidth * std::sin(1.3f * time());
+}
+
+void Benchmark::recordFrame(float const frameTime, float const cpuTime,
+                            float const gpuTime,
+                            PassStats const &frameStats) {
+    if (frame < WARM_UP_FRAMES) {
+        return;
+    }
+
+    frameTimes.push_back(frameTime);
+    cpuTimes.push_back(cpuTime);
+    if (gpuTime >= 0.0f) {
+        gpuTimes.push_back(gpuTime);
+    }
+    totals += frameStats;
+}
+
+void Benchmark::writeResults() const {
+    ofstream file(settings.output);
+    if (!file) {
+        throw runtime_error("Couldn't write " + settings.output);
+    }
+
+    size_t const frames = frameTimes.size();
+    auto const perFrame = [&](std::uint64_t const total) -> double {
+        return frames ? static_cast<double>(total) / frames : 0.0;
+    };
+
+    file << "metric,value\n"
+         << "width," << settings.width << '\n'
+         << "height," << settings.height << '\n'
+         << "duration_s," << settings.duration << '\n'
+         << "frames," << frames << '\n';
+
+    writeTimings(file, "frame", frameTimes);
+    writeTimings(file, "cpu", cpuTimes);
+    writeTimings(file, "gpu", gpuTimes);
+
+    file << "draw_calls_total," << totals.drawCalls << '\n'
+         << "draw_calls_per_frame," << perFrame(totals.drawCalls) << '\n'
+         << "triangles_total," << totals.triangles << '\n'
+         << "triangles_per_frame," << perFrame(totals.triangles) << '\n'
+         << "uniform_uploads_total," << totals.uniformUploads << '\n'
+         << "texture_binds_total," << totals.textureBinds << '\n'
+         << "program_switches_total," << totals.programSwitches << '\n'
+         << "buffer_uploads_total," << totals.bufferUploads << '\n'
+         << "buffer_upload_bytes_total," << totals.bufferUploadBytes
+         << '\n';
+}
+
+// ///////////////////////////////////////////////////////////////////// //
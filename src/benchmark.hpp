@@ -0,0 +1,59 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "frame-stats.hpp"
+
+#include "glm/glm.hpp"
+
+#include <string>
+#include <vector>
+
+// /////////////////////////////////////////// Struct: BenchmarkSettings //
+struct BenchmarkSettings {
+    float duration;
+    int width, height;
+    std::string output;
+};
+
+// //////////////////////////////////////////////////// Class: Benchmark //
+// Drives the game with a fixed timestep along a scripted camera path,
+// so that every run renders the same frames regardless of machine speed.
+class Benchmark {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    static constexpr float TIMESTEP = 1.0f / 60.0f;
+    static constexpr int WARM_UP_FRAMES = 30;
+
+    // ------------------------------------------------------- Behaviour --
+    explicit Benchmark(BenchmarkSettings const &settings);
+
+    bool finished() const;
+    float time() const;
+    void advance();
+
+    glm::vec3 cameraPosition() const;
+    glm::vec3 cameraFront() const;
+
+    // Offset of the palette from the ball, varies the bounce angle; it
+    // stays within half of the palette's half-width, so that the palette
+    // catches the ball while still easing towards it
+    float paletteOffset(float const halfWidth) const;
+
+    // gpuTime is negative when the frame's GPU timings were unavailable
+    void recordFrame(float const frameTime, float const cpuTime,
+                     float const gpuTime, PassStats const &frameStats);
+
+    void writeResults() const;
+
+    // ------------------------------------------------------------ Data --
+    BenchmarkSettings const settings;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------------ Data --
+    int frame;
+    std::vector<float> frameTimes, cpuTimes, gpuTimes;
+    PassStats totals;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // BENCHMARK_H
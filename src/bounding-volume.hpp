@@ -0,0 +1,79 @@
+#ifndef BOUNDING_VOLUME_H
+#define BOUNDING_VOLUME_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <limits>
+
+// ///////////////////////////////////////////////// Struct: BoundingBox //
+struct BoundingBox {
+    glm::vec3 min, max;
+
+    // Box that contains nothing; extending it yields the first point
+    static BoundingBox empty() {
+        float const infinity = std::numeric_limits<float>::infinity();
+        return {glm::vec3(infinity), glm::vec3(-infinity)};
+    }
+
+    // Box that contains everything; never culled (e.g. the skybox)
+    static BoundingBox unbounded() {
+        float const infinity = std::numeric_limits<float>::infinity();
+        return {glm::vec3(-infinity), glm::vec3(infinity)};
+    }
+
+    bool isEmpty() const {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    bool isFinite() const {
+        return !isEmpty() &&
+               glm::all(glm::lessThan(glm::abs(min),
+                        glm::vec3(std::numeric_limits<float>::max()))) &&
+               glm::all(glm::lessThan(glm::abs(max),
+                        glm::vec3(std::numeric_limits<float>::max())));
+    }
+
+    glm::vec3 center() const {
+        return 0.5f * (min + max);
+    }
+
+    glm::vec3 extent() const {
+        return 0.5f * (max - min);
+    }
+
+    void extend(glm::vec3 const &point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void extend(BoundingBox const &box) {
+        min = glm::min(min, box.min);
+        max = glm::max(max, box.max);
+    }
+
+    // Arvo's method: transform the center, and project the extent onto
+    // the absolute values of the rotation-scale part of the matrix
+    BoundingBox transformed(glm::mat4 const &transform) const {
+        if (!isFinite()) {
+            return *this;
+        }
+
+        glm::vec3 const c = glm::vec3(transform * glm::vec4(center(), 1.0f));
+        glm::vec3 const x = extent();
+        glm::vec3 const e = glm::abs(glm::vec3(transform[0])) * x.x +
+                            glm::abs(glm::vec3(transform[1])) * x.y +
+                            glm::abs(glm::vec3(transform[2])) * x.z;
+
+        return {c - e, c + e};
+    }
+};
+
+// ////////////////////////////////////////////// Struct: BoundingSphere //
+struct BoundingSphere {
+    glm::vec3 center;
+    float radius;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // BOUNDING_VOLUME_H
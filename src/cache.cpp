@@ -0,0 +1,106 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "cache.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::ifstream;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+namespace fs = std::filesystem;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    char const *const APPLICATION = "fifth-paragraph";
+
+    fs::path cacheRoot() {
+#ifdef _WIN32
+        if (char const *localAppData = std::getenv("LOCALAPPDATA")) {
+            return fs::path(localAppData) / APPLICATION / "cache";
+        }
+#else
+        if (char const *xdgCache = std::getenv("XDG_CACHE_HOME")) {
+            return fs::path(xdgCache) / APPLICATION;
+        }
+        if (char const *home = std::getenv("HOME")) {
+            return fs::path(home) / ".cache" / APPLICATION;
+        }
+#endif
+        return fs::path("cache");
+    }
+}
+
+// ///////////////////////////////////////////////////////// Disk caching //
+string cache::directory(string const &kind) {
+    fs::path const path = cacheRoot() / kind;
+
+    std::error_code error;
+    fs::create_directories(path, error);
+    if (error) {
+        return string();
+    }
+    return path.string();
+}
+
+std::uint64_t cache::hash(void const *data, std::size_t const size,
+                          std::uint64_t const seed) {
+    auto const *bytes = static_cast<unsigned char const *>(data);
+
+    std::uint64_t hash = seed;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::uint64_t cache::hash(string const &data, std::uint64_t const seed) {
+    return hash(data.data(), data.size(), seed);
+}
+
+string cache::hex(std::uint64_t value) {
+    char const *const digits = "0123456789abcdef";
+
+    string text(16, '0');
+    for (int i = 15; i >= 0; --i, value >>= 4u) {
+        text[i] = digits[value & 0xfu];
+    }
+    return text;
+}
+
+bool cache::read(string const &filename, vector<char> &data) {
+    ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+
+    std::streamsize const size = file.tellg();
+    data.resize(size);
+    file.seekg(0);
+    return static_cast<bool>(file.read(data.data(), size));
+}
+
+void cache::write(string const &filename, vector<char> const &data) {
+    string const temporary = filename + ".tmp";
+    {
+        ofstream file(temporary, std::ios::binary);
+        if (!file.write(data.data(), data.size())) {
+            return;
+        }
+    }
+
+    std::error_code error;
+    fs::rename(temporary, filename, error);
+    if (error) {
+        fs::remove(temporary, error);
+    }
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,34 @@
+#ifndef CACHE_H
+#define CACHE_H
+// //////////////////////////////////////////////////////////// Includes //
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ///////////////////////////////////////////////////////// Disk caching //
+namespace cache {
+    std::uint64_t const HASH_SEED = 14695981039346656037ull;
+
+    // Per-user directory for cached files of the given kind, created on
+    // demand; empty when it can't be created
+    std::string directory(std::string const &kind);
+
+    // 64-bit FNV-1a, chainable through the seed
+    std::uint64_t hash(void const *data, std::size_t const size,
+                       std::uint64_t const seed = HASH_SEED);
+    std::uint64_t hash(std::string const &data,
+                       std::uint64_t const seed = HASH_SEED);
+
+    std::string hex(std::uint64_t const value);
+
+    // False when the file doesn't exist or can't be read
+    bool read(std::string const &filename, std::vector<char> &data);
+
+    // Writes through a temporary file, so that a crash never leaves a
+    // truncated entry behind; failures only cost the cache entry
+    void write(std::string const &filename, std::vector<char> const &data);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // CACHE_H
@@ -0,0 +1,29 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "draw-data.hpp"
+
+#include <utility>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::shared_ptr;
+using std::vector;
+
+// ///////////////////////////////////////////////////// Class: DrawData //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+DrawData::DrawData(shared_ptr<StreamBuffer> stream)
+        : stream(std::move(stream)) {
+}
+
+void DrawData::upload(vector<DrawParameters> const &draws) {
+    if (draws.empty()) {
+        return;
+    }
+
+    GLsizeiptr const size = draws.size() * sizeof(DrawParameters);
+    StreamBuffer::Allocation const allocation = stream->upload(
+            draws.data(), size, stream->storageAlignment());
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, BINDING, allocation.buffer,
+                      allocation.offset, size);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
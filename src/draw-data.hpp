@@ -0,0 +1,48 @@
+#ifndef DRAW_DATA_H
+#define DRAW_DATA_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "opengl-headers.hpp"
+#include "stream-buffer.hpp"
+
+#include "glm/glm.hpp"
+
+#include <memory>
+#include <vector>
+
+// ////////////////////////////////////////////// Struct: DrawParameters //
+// What the model and depth shaders know about one mesh instance, laid out
+// like DrawParameters in res/shaders/include/draw-data.glsl (std430)
+struct DrawParameters {
+    glm::mat4 world;
+    glm::mat4 transform;
+    glm::mat4 previousTransform;
+    // x: layer in the MaterialTable
+    glm::uvec4 material;
+};
+
+// ///////////////////////////////////////////////////// Class: DrawData //
+// Shader storage range of DrawParameters in the StreamBuffer, written
+// anew before every pass. An instanced draw reads entry
+// firstDraw + gl_InstanceID.
+class DrawData {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    // Shader storage binding shared with draw-data.glsl
+    static constexpr int BINDING = 3;
+
+    // ------------------------------------------------------- Behaviour --
+    explicit DrawData(std::shared_ptr<StreamBuffer> stream);
+
+    DrawData(DrawData const &) = delete;
+    DrawData &operator=(DrawData const &) = delete;
+
+    // Streams the draws and binds them
+    void upload(std::vector<DrawParameters> const &draws);
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------------ Data --
+    std::shared_ptr<StreamBuffer> const stream;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // DRAW_DATA_H
@@ -0,0 +1,60 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "dynamic-resolution.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// //////////////////////////////////////////// Class: DynamicResolution //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+DynamicResolution::DynamicResolution(
+        DynamicResolutionSettings const &settings)
+        : settings(settings),
+          current(settings.maxScale),
+          average(-1.0f),
+          settling(0) {
+}
+
+float DynamicResolution::update(float const gpuTime) {
+    if (gpuTime <= 0.0f) {
+        return current;
+    }
+    if (settling > 0) {
+        --settling;
+        return current;
+    }
+
+    float const target = HEADROOM * settings.budget;
+    average = average < 0.0f
+              ? gpuTime
+              : average + SMOOTHING * (gpuTime - average);
+
+    if (gpuTime > target) {
+        // React to the single frame, not the average, to catch spikes
+        float const scale = std::max(
+                current * std::sqrt(target / gpuTime), settings.minScale);
+        if (scale < current) {
+            // Predict the time at the new scale for the running average
+            average = gpuTime * (scale * scale) / (current * current);
+            current = scale;
+            settling = Profiler::FRAME_LATENCY;
+        }
+    } else {
+        float const scale = current * std::sqrt(target / average);
+        current = std::min({scale, current * (1.0f + GROWTH_RATE),
+                            settings.maxScale});
+        current = std::max(current, settings.minScale);
+    }
+    return current;
+}
+
+float DynamicResolution::scale() const {
+    return current;
+}
+
+float DynamicResolution::averageTime() const {
+    return average;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
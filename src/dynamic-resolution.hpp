@@ -0,0 +1,55 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+// /////////////////////////////////// Struct: DynamicResolutionSettings //
+struct DynamicResolutionSettings {
+    float minScale, maxScale;
+
+    // GPU time a frame may take, in milliseconds
+    float budget;
+};
+
+// //////////////////////////////////////////// Class: DynamicResolution //
+// Picks the render scale of the 3D pass from measured GPU frame times.
+// GPU time is assumed proportional to the pixel count, i.e. the square of
+// the scale. Over budget the scale drops at once to what should fit,
+// under budget it grows back gradually, so a load spike costs a frame or
+// two of lower resolution rather than a missed vsync deadline.
+class DynamicResolution {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    // Fraction of the budget aimed at, leaves room for jitter
+    static constexpr float HEADROOM = 0.85f;
+
+    // Largest relative growth of the scale per frame
+    static constexpr float GROWTH_RATE = 0.02f;
+
+    // Weight of the newest sample in the running average
+    static constexpr float SMOOTHING = 0.1f;
+
+    // ------------------------------------------------------- Behaviour --
+    explicit DynamicResolution(DynamicResolutionSettings const &settings);
+
+    // gpuTime is negative when the frame's GPU timings were unavailable;
+    // returns the scale for the next frame
+    float update(float const gpuTime);
+
+    float scale() const;
+
+    // Most recent running average of the GPU time, in milliseconds
+    float averageTime() const;
+
+    // ------------------------------------------------------------ Data --
+    DynamicResolutionSettings const settings;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------------ Data --
+    float current;
+    float average;
+
+    // Timings arrive a few frames late; after a drop, the next ones were
+    // still measured at the old scale and must not trigger another drop
+    int settling;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // DYNAMIC_RESOLUTION_H
@@ -0,0 +1,269 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "environment-lighting.hpp"
+#include "shader.hpp"
+#include "cache.hpp"
+#include "frame-stats.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::string;
+using std::vector;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    // Baking shaders and everything they include, part of the cache key
+    char const *const BAKE_FILES[] = {
+            "res/shaders/ibl/irradiance.glsl",
+            "res/shaders/ibl/prefilter.glsl",
+            "res/shaders/ibl/brdf.glsl",
+            "res/shaders/include/cubemap.glsl",
+            "res/shaders/include/importance-sampling.glsl"};
+
+    int const GROUP_SIZE = 8;
+
+    struct CacheHeader {
+        std::uint32_t magic;
+        std::uint32_t irradianceSize;
+        std::uint32_t prefilteredSize;
+        std::uint32_t prefilteredLevels;
+        std::uint32_t brdfLutSize;
+    };
+
+    std::uint32_t const CACHE_MAGIC = 0x4c424946u;
+
+    // Half floats: four channels for the cubemaps, two for the table
+    std::size_t cubeFaceBytes(int const size) {
+        return static_cast<std::size_t>(size) * size * 4 * 2;
+    }
+
+    std::size_t brdfLutBytes() {
+        return static_cast<std::size_t>(EnvironmentLighting::BRDF_LUT_SIZE) *
+               EnvironmentLighting::BRDF_LUT_SIZE * 2 * 2;
+    }
+
+    std::size_t cacheBytes() {
+        std::size_t bytes = sizeof(CacheHeader) +
+                6 * cubeFaceBytes(EnvironmentLighting::IRRADIANCE_SIZE) +
+                brdfLutBytes();
+        for (int level = 0; level < EnvironmentLighting::PREFILTERED_LEVELS;
+             ++level) {
+            bytes += 6 * cubeFaceBytes(
+                    EnvironmentLighting::PREFILTERED_SIZE >> level);
+        }
+        return bytes;
+    }
+
+    int groups(int const size) {
+        return (size + GROUP_SIZE - 1) / GROUP_SIZE;
+    }
+
+    string cacheFile(vector<string> const &skyboxFilenames) {
+        string const directory = cache::directory("environment");
+        if (directory.empty()) {
+            return string();
+        }
+
+        std::uint64_t key = cache::HASH_SEED;
+        vector<char> data;
+        for (string const &filename : skyboxFilenames) {
+            if (!cache::read(filename, data)) {
+                return string();
+            }
+            key = cache::hash(data.data(), data.size(), key);
+        }
+        for (char const *filename : BAKE_FILES) {
+            if (!cache::read(filename, data)) {
+                return string();
+            }
+            key = cache::hash(data.data(), data.size(), key);
+        }
+        return directory + "/" + cache::hex(key) + ".bin";
+    }
+}
+
+// ////////////////////////////////////////// Class: EnvironmentLighting //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+EnvironmentLighting::EnvironmentLighting(
+        GLuint const skybox, vector<string> const &skyboxFilenames) {
+    createTextures();
+
+    string const filename = cacheFile(skyboxFilenames);
+    if (!load(filename)) {
+        bake(skybox);
+        save(filename);
+    }
+}
+
+void EnvironmentLighting::bind() const {
+    glActiveTexture(GL_TEXTURE0 + IRRADIANCE_UNIT);
+    gl::bindTexture(GL_TEXTURE_CUBE_MAP, irradiance.id());
+    glActiveTexture(GL_TEXTURE0 + PREFILTERED_UNIT);
+    gl::bindTexture(GL_TEXTURE_CUBE_MAP, prefiltered.id());
+    glActiveTexture(GL_TEXTURE0 + BRDF_LUT_UNIT);
+    gl::bindTexture(GL_TEXTURE_2D, brdfLut.id());
+}
+
+// ============================================== Private implementation ==
+// ----------------------------------------------------------- Behaviour --
+void EnvironmentLighting::createTextures() {
+    auto const cubemap = [](int const size, int const levels) {
+        gl::Texture texture(GL_TEXTURE_CUBE_MAP, levels, GL_RGBA16F, size,
+                            size);
+        texture.parameter(GL_TEXTURE_MIN_FILTER,
+                          levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        texture.parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        texture.parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        texture.parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        texture.parameter(GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        return texture;
+    };
+    irradiance = cubemap(IRRADIANCE_SIZE, 1);
+    prefiltered = cubemap(PREFILTERED_SIZE, PREFILTERED_LEVELS);
+
+    // Seamless filtering hides the face edges of the blurry levels
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    brdfLut = gl::Texture(GL_TEXTURE_2D, 1, GL_RG16F, BRDF_LUT_SIZE,
+                          BRDF_LUT_SIZE);
+    brdfLut.parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    brdfLut.parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    brdfLut.parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    brdfLut.parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void EnvironmentLighting::bake(GLuint const skybox) {
+    // The skybox has no mip chain of its own; the prefilter samples
+    // lower levels to keep few samples from aliasing
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, skybox);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+
+    GLint skyboxSize;
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0,
+                             GL_TEXTURE_WIDTH, &skyboxSize);
+
+    // ''''''''''''''''''''''''''''''''''''''''''''''''' Diffuse irradiance
+    Shader irradianceShader("res/shaders/ibl/irradiance.glsl");
+    irradianceShader.use();
+    irradianceShader.uniform1i("texEnvironment", 0);
+    irradianceShader.uniform1i("size", IRRADIANCE_SIZE);
+    glBindImageTexture(0, irradiance.id(), 0, GL_TRUE, 0, GL_WRITE_ONLY,
+                       GL_RGBA16F);
+    glDispatchCompute(groups(IRRADIANCE_SIZE), groups(IRRADIANCE_SIZE), 6);
+
+    // ''''''''''''''''''''''''''''''''''''''''''''''' Prefiltered specular
+    Shader prefilterShader("res/shaders/ibl/prefilter.glsl");
+    prefilterShader.use();
+    prefilterShader.uniform1i("texEnvironment", 0);
+    prefilterShader.uniform1f("environmentSize",
+                              static_cast<float>(skyboxSize));
+    for (int level = 0; level < PREFILTERED_LEVELS; ++level) {
+        int const size = PREFILTERED_SIZE >> level;
+        prefilterShader.uniform1i("size", size);
+        prefilterShader.uniform1f(
+                "roughness",
+                static_cast<float>(level) / (PREFILTERED_LEVELS - 1));
+        glBindImageTexture(0, prefiltered.id(), level, GL_TRUE, 0,
+                           GL_WRITE_ONLY, GL_RGBA16F);
+        glDispatchCompute(groups(size), groups(size), 6);
+    }
+
+    // '''''''''''''''''''''''''''''''''''''''''''''''''''' BRDF lookup table
+    Shader brdfShader("res/shaders/ibl/brdf.glsl");
+    brdfShader.use();
+    brdfShader.uniform1i("size", BRDF_LUT_SIZE);
+    glBindImageTexture(0, brdfLut.id(), 0, GL_FALSE, 0, GL_WRITE_ONLY,
+                       GL_RG16F);
+    glDispatchCompute(groups(BRDF_LUT_SIZE), groups(BRDF_LUT_SIZE), 1);
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT |
+                    GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    // Leave the skybox sampled as before
+    glBindTexture(GL_TEXTURE_CUBE_MAP, skybox);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+bool EnvironmentLighting::load(string const &filename) {
+    vector<char> data;
+    if (filename.empty() || !cache::read(filename, data) ||
+        data.size() != cacheBytes()) {
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != CACHE_MAGIC ||
+        header.irradianceSize != IRRADIANCE_SIZE ||
+        header.prefilteredSize != PREFILTERED_SIZE ||
+        header.prefilteredLevels != PREFILTERED_LEVELS ||
+        header.brdfLutSize != BRDF_LUT_SIZE) {
+        return false;
+    }
+
+    char const *next = data.data() + sizeof(header);
+    auto const upload = [&next](GLuint const texture, int const size,
+                                int const level) {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        for (int face = 0; face < 6; ++face) {
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level,
+                            0, 0, size, size, GL_RGBA, GL_HALF_FLOAT, next);
+            next += cubeFaceBytes(size);
+        }
+    };
+    upload(irradiance.id(), IRRADIANCE_SIZE, 0);
+    for (int level = 0; level < PREFILTERED_LEVELS; ++level) {
+        upload(prefiltered.id(), PREFILTERED_SIZE >> level, level);
+    }
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    glBindTexture(GL_TEXTURE_2D, brdfLut.id());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, BRDF_LUT_SIZE, BRDF_LUT_SIZE,
+                    GL_RG, GL_HALF_FLOAT, next);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+}
+
+void EnvironmentLighting::save(string const &filename) const {
+    if (filename.empty()) {
+        return;
+    }
+
+    vector<char> data(cacheBytes());
+    CacheHeader const header = {
+            CACHE_MAGIC, IRRADIANCE_SIZE, PREFILTERED_SIZE,
+            PREFILTERED_LEVELS, BRDF_LUT_SIZE};
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    char *next = data.data() + sizeof(header);
+    auto const download = [&next](GLuint const texture, int const size,
+                                  int const level) {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        for (int face = 0; face < 6; ++face) {
+            glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level,
+                          GL_RGBA, GL_HALF_FLOAT, next);
+            next += cubeFaceBytes(size);
+        }
+    };
+    download(irradiance.id(), IRRADIANCE_SIZE, 0);
+    for (int level = 0; level < PREFILTERED_LEVELS; ++level) {
+        download(prefiltered.id(), PREFILTERED_SIZE >> level, level);
+    }
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    glBindTexture(GL_TEXTURE_2D, brdfLut.id());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_HALF_FLOAT, next);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    cache::write(filename, data);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
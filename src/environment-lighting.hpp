@@ -0,0 +1,51 @@
+#ifndef ENVIRONMENT_LIGHTING_H
+#define ENVIRONMENT_LIGHTING_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "opengl-headers.hpp"
+#include "gl-resources.hpp"
+
+#include <string>
+#include <vector>
+
+// ////////////////////////////////////////// Class: EnvironmentLighting //
+// Image-based lighting precomputed from the skybox: a diffuse irradiance
+// cubemap, a specular cubemap prefiltered for increasing roughness along
+// its mip chain and the split-sum BRDF lookup table. Baked with compute
+// shaders on first run and cached on disk, keyed by the skybox images
+// and the baking shaders.
+class EnvironmentLighting {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    static constexpr int IRRADIANCE_SIZE = 32;
+    static constexpr int PREFILTERED_SIZE = 128;
+    static constexpr int PREFILTERED_LEVELS = 5;
+    static constexpr int BRDF_LUT_SIZE = 256;
+
+    // Texture units the model shader samples them from
+    static constexpr int IRRADIANCE_UNIT = 7;
+    static constexpr int PREFILTERED_UNIT = 8;
+    static constexpr int BRDF_LUT_UNIT = 9;
+
+    // ------------------------------------------------------- Behaviour --
+    EnvironmentLighting(GLuint const skybox,
+                        std::vector<std::string> const &skyboxFilenames);
+
+    EnvironmentLighting(EnvironmentLighting const &) = delete;
+    EnvironmentLighting &operator=(EnvironmentLighting const &) = delete;
+
+    void bind() const;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------- Behaviour --
+    void createTextures();
+    void bake(GLuint const skybox);
+
+    bool load(std::string const &filename);
+    void save(std::string const &filename) const;
+
+    // ------------------------------------------------------------ Data --
+    gl::Texture irradiance, prefiltered, brdfLut;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // ENVIRONMENT_LIGHTING_H
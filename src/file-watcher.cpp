@@ -0,0 +1,126 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "file-watcher.hpp"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::string;
+using std::vector;
+
+namespace fs = std::filesystem;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    // How often modification times are compared without inotify
+    auto const SCAN_INTERVAL = std::chrono::milliseconds(500);
+}
+
+// //////////////////////////////////////////////// Class: FileWatcher //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+FileWatcher::FileWatcher(string const &directory)
+        : directory(directory),
+          lastScan(std::chrono::steady_clock::now()) {
+#ifdef __linux__
+    descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (descriptor >= 0) {
+        // Editors either write in place or rename a new file over the old
+        uint32_t const mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+        std::error_code error;
+        vector<string> directories = {directory};
+        for (fs::recursive_directory_iterator it(directory, error), end;
+             !error && it != end; it.increment(error)) {
+            if (it->is_directory()) {
+                directories.push_back(it->path().generic_string());
+            }
+        }
+        for (string const &watched : directories) {
+            int const watch = inotify_add_watch(descriptor,
+                                                watched.c_str(), mask);
+            if (watch >= 0) {
+                watches[watch] = watched;
+            }
+        }
+        return;
+    }
+#endif
+    scanModificationTimes();
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (descriptor >= 0) {
+        close(descriptor);
+    }
+#endif
+}
+
+vector<string> FileWatcher::changes() {
+#ifdef __linux__
+    if (descriptor >= 0) {
+        vector<string> changed;
+
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(descriptor, buffer, sizeof(buffer))) > 0) {
+            for (char *p = buffer; p < buffer + length;) {
+                auto const *event = reinterpret_cast<inotify_event *>(p);
+                if (event->len > 0 && watches.count(event->wd)) {
+                    string const file = watches[event->wd] + "/" +
+                                        event->name;
+                    if (std::find(changed.begin(), changed.end(), file) ==
+                        changed.end()) {
+                        changed.push_back(file);
+                    }
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        return changed;
+    }
+#endif
+
+    auto const now = std::chrono::steady_clock::now();
+    if (now - lastScan < SCAN_INTERVAL) {
+        return {};
+    }
+    lastScan = now;
+    return scanModificationTimes();
+}
+
+// ============================================== Private implementation ==
+// ----------------------------------------------------------- Behaviour --
+vector<string> FileWatcher::scanModificationTimes() {
+    vector<string> changed;
+
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(directory, error), end;
+         !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+
+        string const file = it->path().generic_string();
+        fs::file_time_type const time = fs::last_write_time(it->path(),
+                                                            error);
+        auto const known = modified.find(file);
+        if (known != modified.end() && known->second != time) {
+            changed.push_back(file);
+        }
+        modified[file] = time;
+    }
+    return changed;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
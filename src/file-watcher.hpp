@@ -0,0 +1,43 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+// //////////////////////////////////////////////////////////// Includes //
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// ///////////////////////////////////////////////// Class: FileWatcher //
+// Reports files written under a directory tree. Uses inotify on Linux
+// and falls back to comparing modification times elsewhere.
+class FileWatcher {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    explicit FileWatcher(std::string const &directory);
+    ~FileWatcher();
+
+    FileWatcher(FileWatcher const &) = delete;
+    FileWatcher &operator=(FileWatcher const &) = delete;
+
+    // Files changed since the last call, as paths starting with the
+    // watched directory; never blocks
+    std::vector<std::string> changes();
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------- Behaviour --
+    std::vector<std::string> scanModificationTimes();
+
+    // ------------------------------------------------------------ Data --
+    std::string const directory;
+
+#ifdef __linux__
+    int descriptor;
+    std::map<int, std::string> watches;
+#endif
+
+    std::map<std::string, std::filesystem::file_time_type> modified;
+    std::chrono::steady_clock::time_point lastScan;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // FILE_WATCHER_H
@@ -1,11 +1,17 @@
 // //////////////////////////////////////////////////////////// Includes //
 #include "opengl-headers.hpp"
 #include "shader.hpp"
+#include "frame-stats.hpp"
+#include "gl-resources.hpp"
+#include "stream-buffer.hpp"
 
+#include <cstddef>
+#include <cstring>
 #include <memory>
 #include <map>
-#include <exception>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -14,35 +20,44 @@
 class Font {
 private:
     struct Character {
-        GLuint texture;
+        // Empty for glyphs without pixels, such as the space
+        gl::Texture texture;
         glm::ivec2 glyphSize;
         glm::ivec2 bearing;
         GLuint advance;
     };
 
-    GLuint vao, vbo;
+    // Quad of one glyph: position and texture coordinates per vertex
+    using GlyphQuad = float[6][4];
+
+    gl::VertexArray vao;
     std::map<GLchar, Character> characters;
     std::shared_ptr<Shader> shader;
+    std::shared_ptr<StreamBuffer> stream;
 
 public:
     Font(std::string const &path, int const &fontHeight,
-         std::shared_ptr<Shader> const &shader) : shader(shader) {
+         std::shared_ptr<Shader> const &shader,
+         std::shared_ptr<StreamBuffer> const &stream)
+            : shader(shader), stream(stream) {
         // Initialize FreeType library
         FT_Library ft;
         if (FT_Init_FreeType(&ft)) {
-            throw std::exception("Failed to init FreeType library!");
+            throw std::runtime_error("Failed to init FreeType library!");
         }
 
         // Load font
         FT_Face face;
         if (FT_New_Face(ft, path.c_str(), 0, &face)) {
-            throw std::exception("Failed to load font!");
+            throw std::runtime_error("Failed to load font!");
         }
 
         // Set glyphs' pixel size
         FT_Set_Pixel_Sizes(face, 0, fontHeight);
 
-        // Disable byte-alignment restriction
+        // Disable byte-alignment restriction for the glyphs only
+        GLint unpackAlignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
         // Load first 128 characters of ASCII set
@@ -53,69 +68,46 @@ public:
                 continue;
             }
 
-            // Generate OpenGL resource
-            GLuint texture;
-            glGenTextures(1, &texture);
+            int const width = face->glyph->bitmap.width;
+            int const height = face->glyph->bitmap.rows;
 
             // Setup the texture
-            glBindTexture(GL_TEXTURE_2D, texture);
-            {
+            gl::Texture texture;
+            if (width > 0 && height > 0) {
+                texture = gl::Texture(GL_TEXTURE_2D, 1, GL_R8,
+                                      width, height);
+
                 // Pass image to OpenGL
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RED,
-                             face->glyph->bitmap.width,
-                             face->glyph->bitmap.rows,
-                             0, GL_RED, GL_UNSIGNED_BYTE,
-                             face->glyph->bitmap.buffer);
+                texture.upload(0, 0, 0, 0, width, height, 1, GL_RED,
+                               GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
 
                 // Set texture parameters
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
-                                GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
-                                GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                                GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-                                GL_LINEAR);
+                texture.parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                texture.parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                texture.parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                texture.parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             }
-            glBindTexture(GL_TEXTURE_2D, 0);
 
             // Save character data
-            characters.insert(std::pair<GLchar, Character>(c, {
-                    texture,
-                    glm::ivec2(face->glyph->bitmap.width,
-                               face->glyph->bitmap.rows),
+            characters.emplace(c, Character{
+                    std::move(texture),
+                    glm::ivec2(width, height),
                     glm::ivec2(face->glyph->bitmap_left,
                                face->glyph->bitmap_top),
                     (GLuint) face->glyph->advance.x
-            }));
+            });
         }
 
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
         // Clean up resources
         FT_Done_Face(face);
         FT_Done_FreeType(ft);
 
-        // Configure buffers
-        glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &vbo);
-
-        glBindVertexArray(vao);
-        {
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            {
-                glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * 2 * 4,
-                             0, GL_DYNAMIC_DRAW);
-
-                glEnableVertexAttribArray(0);
-                glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE,
-                                      4 * sizeof(GLfloat), 0);
-
-                glEnableVertexAttribArray(1);
-                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE,
-                                      4 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
-            }
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-        }
-        glBindVertexArray(0);
+        // Configure vertex layout, quads are streamed when rendering
+        vao = gl::VertexArray::create();
+        vao.attribute(0, 0, 2, GL_FLOAT, false, 0);
+        vao.attribute(1, 0, 2, GL_FLOAT, false, 2 * sizeof(GLfloat));
     }
 
     void render(std::string const &text,
@@ -131,49 +123,50 @@ public:
                                                     0.0f, (float)displayHeight,
                                                     0.0f, 1.0f)));
 
-        glBindVertexArray(vao);
+        // Write every glyph's quad at once
+        StreamBuffer::Allocation const allocation = stream->allocate(
+                text.size() * sizeof(GlyphQuad), sizeof(GLfloat));
+        GlyphQuad *quads = static_cast<GlyphQuad *>(allocation.data);
+
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            Character const &character = characters[text[i]];
+
+            float xPos = x + character.bearing.x * scale;
+            float yPos =
+                    y -
+                    (character.glyphSize.y - character.bearing.y) *
+                    scale;
+
+            float width = character.glyphSize.x * scale;
+            float height = character.glyphSize.y * scale;
+
+            float const vertices[6][4] = {
+                    {xPos,         yPos + height, 0.0, 0.0},
+                    {xPos,         yPos,          0.0, 1.0},
+                    {xPos + width, yPos,          1.0, 1.0},
+
+                    {xPos,         yPos + height, 0.0, 0.0},
+                    {xPos + width, yPos,          1.0, 1.0},
+                    {xPos + width, yPos + height, 1.0, 0.0}
+            };
+            std::memcpy(quads[i], vertices, sizeof(GlyphQuad));
+
+            // Move cursor to the next glyph
+            x += (character.advance >> 6) * scale;
+        }
+
+        vao.vertexBuffer(0, allocation.buffer, 4 * sizeof(GLfloat),
+                         allocation.offset);
+        vao.bind();
         {
-            for (auto const i : text) {
-                Character character = characters[i];
-
-                float xPos = x + character.bearing.x * scale;
-                float yPos =
-                        y -
-                        (character.glyphSize.y - character.bearing.y) *
-                        scale;
-
-                float width = character.glyphSize.x * scale;
-                float height = character.glyphSize.y * scale;
-
-                // Update buffer content
-                float vertices[6][4] = {
-                        {xPos,         yPos + height, 0.0, 0.0},
-                        {xPos,         yPos,          0.0, 1.0},
-                        {xPos + width, yPos,          1.0, 1.0},
-
-                        {xPos,         yPos + height, 0.0, 0.0},
-                        {xPos + width, yPos,          1.0, 1.0},
-                        {xPos + width, yPos + height, 1.0, 0.0}
-                };
-
-                glBindBuffer(GL_ARRAY_BUFFER, vbo);
-                {
-                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices),
-                                    vertices);
-                }
-                glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-                // Render glyph
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, character.texture);
-                {
-                    glDrawArrays(GL_TRIANGLES, 0, 2 * 3);
-                }
-                glBindTexture(GL_TEXTURE_2D, 0);
-
-                // Move cursor to the next glyph
-                x += (character.advance >> 6) * scale;
+            // Render glyphs, one texture each
+            glActiveTexture(GL_TEXTURE0);
+            for (std::size_t i = 0; i < text.size(); ++i) {
+                gl::bindTexture(GL_TEXTURE_2D,
+                                characters[text[i]].texture.id());
+                gl::drawArrays(GL_TRIANGLES, static_cast<GLint>(6 * i), 6);
             }
+            gl::bindTexture(GL_TEXTURE_2D, 0);
         }
         glBindVertexArray(0);
     }
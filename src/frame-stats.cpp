@@ -0,0 +1,106 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "frame-stats.hpp"
+
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::ofstream;
+using std::runtime_error;
+using std::string;
+using std::unique_ptr;
+
+// /////////////////////////////////////////////////// Struct: PassStats //
+PassStats &PassStats::operator+=(PassStats const &other) {
+    drawCalls += other.drawCalls;
+    triangles += other.triangles;
+    uniformUploads += other.uniformUploads;
+    textureBinds += other.textureBinds;
+    programSwitches += other.programSwitches;
+    bufferUploads += other.bufferUploads;
+    bufferUploadBytes += other.bufferUploadBytes;
+    return *this;
+}
+
+// ////////////////////////////////////////////////// Struct: FrameStats //
+PassStats const *FrameStats::pass(string const &name) const {
+    for (auto const &pass : passes) {
+        if (pass.first == name) {
+            return &pass.second;
+        }
+    }
+    return nullptr;
+}
+
+// ////////////////////////////////////////////////// Statistics control //
+namespace {
+    FrameStats recording{}, completed{};
+    PassStats outsideOfFrame{};
+    bool insideFrame = false;
+    std::uint64_t frameCounter = 0;
+
+    unique_ptr<ofstream> csv;
+
+    void writeCsvRow(string const &pass, PassStats const &stats) {
+        *csv << completed.frame << ',' << pass << ','
+             << stats.drawCalls << ',' << stats.triangles << ','
+             << stats.uniformUploads << ',' << stats.textureBinds << ','
+             << stats.programSwitches << ',' << stats.bufferUploads << ','
+             << stats.bufferUploadBytes << '\n';
+    }
+}
+
+void stats::beginFrame() {
+    recording = FrameStats{};
+    recording.frame = frameCounter++;
+    recording.passes.emplace_back("Other", PassStats{});
+    insideFrame = true;
+}
+
+void stats::beginPass(string const &name) {
+    recording.passes.emplace_back(name, PassStats{});
+}
+
+void stats::endFrame() {
+    insideFrame = false;
+
+    recording.total = PassStats{};
+    for (auto const &pass : recording.passes) {
+        recording.total += pass.second;
+    }
+    completed = recording;
+
+    if (csv) {
+        for (auto const &pass : completed.passes) {
+            writeCsvRow(pass.first, pass.second);
+        }
+        writeCsvRow("Total", completed.total);
+    }
+}
+
+PassStats &stats::current() {
+    return insideFrame ? recording.passes.back().second : outsideOfFrame;
+}
+
+FrameStats const &stats::lastFrame() {
+    return completed;
+}
+
+void stats::openCsv(string const &filename) {
+    csv.reset(new ofstream(filename));
+    if (!*csv) {
+        csv = nullptr;
+        throw runtime_error(("Couldn't write " + filename).c_str());
+    }
+
+    *csv << "frame,pass,drawCalls,triangles,uniformUploads,textureBinds,"
+            "programSwitches,bufferUploads,bufferUploadBytes\n";
+}
+
+void stats::closeCsv() {
+    csv = nullptr;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,153 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "opengl-headers.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// /////////////////////////////////////////////////// Struct: PassStats //
+struct PassStats {
+    std::uint64_t drawCalls;
+    std::uint64_t triangles;
+    std::uint64_t uniformUploads;
+    std::uint64_t textureBinds;
+    std::uint64_t programSwitches;
+    std::uint64_t bufferUploads;
+    std::uint64_t bufferUploadBytes;
+
+    PassStats &operator+=(PassStats const &other);
+};
+
+// ////////////////////////////////////////////////// Struct: FrameStats //
+struct FrameStats {
+    std::uint64_t frame;
+    PassStats total;
+    std::vector<std::pair<std::string, PassStats>> passes;
+
+    PassStats const *pass(std::string const &name) const;
+};
+
+// ////////////////////////////////////////////////// Statistics control //
+namespace stats {
+    void beginFrame();
+    void beginPass(std::string const &name);
+    void endFrame();
+
+    // Counters of the pass currently being recorded
+    PassStats &current();
+
+    // Last completed frame
+    FrameStats const &lastFrame();
+
+    // Append one row per pass (and one for the total) for every frame
+    void openCsv(std::string const &filename);
+    void closeCsv();
+}
+
+// //////////////////////////////////////// Instrumented GL entry points //
+namespace gl {
+    inline void useProgram(GLuint const program) {
+        static GLuint currentProgram = 0;
+        if (program != currentProgram) {
+            stats::current().programSwitches++;
+            currentProgram = program;
+        }
+        glUseProgram(program);
+    }
+
+    inline void bindTexture(GLenum const target, GLuint const texture) {
+        stats::current().textureBinds++;
+        glBindTexture(target, texture);
+    }
+
+    inline void bufferData(GLenum const target, GLsizeiptr const size,
+                           void const *data, GLenum const usage) {
+        stats::current().bufferUploads++;
+        stats::current().bufferUploadBytes += size;
+        glBufferData(target, size, data, usage);
+    }
+
+    inline void bufferSubData(GLenum const target, GLintptr const offset,
+                              GLsizeiptr const size, void const *data) {
+        stats::current().bufferUploads++;
+        stats::current().bufferUploadBytes += size;
+        glBufferSubData(target, offset, size, data);
+    }
+
+    inline void drawArrays(GLenum const mode, GLint const first,
+                           GLsizei const count) {
+        stats::current().drawCalls++;
+        if (mode == GL_TRIANGLES) {
+            stats::current().triangles += count / 3;
+        }
+        glDrawArrays(mode, first, count);
+    }
+
+    inline void drawElements(GLenum const mode, GLsizei const count,
+                             GLenum const type, void const *indices) {
+        stats::current().drawCalls++;
+        if (mode == GL_TRIANGLES) {
+            stats::current().triangles += count / 3;
+        }
+        glDrawElements(mode, count, type, indices);
+    }
+
+    inline void drawElementsBaseVertex(GLenum const mode,
+                                       GLsizei const count,
+                                       GLenum const type,
+                                       void const *indices,
+                                       GLint const baseVertex) {
+        stats::current().drawCalls++;
+        if (mode == GL_TRIANGLES) {
+            stats::current().triangles += count / 3;
+        }
+        glDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+    }
+
+    inline void drawElementsInstanced(GLenum const mode, GLsizei const count,
+                                      GLenum const type,
+                                      void const *indices,
+                                      GLsizei const instances) {
+        stats::current().drawCalls++;
+        if (mode == GL_TRIANGLES) {
+            stats::current().triangles +=
+                    static_cast<std::uint64_t>(count / 3) * instances;
+        }
+        glDrawElementsInstanced(mode, count, type, indices, instances);
+    }
+
+    inline void uniform1i(GLint const location, GLint const a) {
+        stats::current().uniformUploads++;
+        glUniform1i(location, a);
+    }
+
+    inline void uniform1f(GLint const location, GLfloat const a) {
+        stats::current().uniformUploads++;
+        glUniform1f(location, a);
+    }
+
+    inline void uniform2f(GLint const location,
+                          GLfloat const a, GLfloat const b) {
+        stats::current().uniformUploads++;
+        glUniform2f(location, a, b);
+    }
+
+    inline void uniform3f(GLint const location,
+                          GLfloat const a, GLfloat const b, GLfloat const c) {
+        stats::current().uniformUploads++;
+        glUniform3f(location, a, b, c);
+    }
+
+    inline void uniformMatrix4fv(GLint const location, GLsizei const count,
+                                 GLboolean const transpose,
+                                 GLfloat const *value) {
+        stats::current().uniformUploads++;
+        glUniformMatrix4fv(location, count, transpose, value);
+    }
+}
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // FRAME_STATS_H
@@ -0,0 +1,158 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "frustum.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::size_t;
+using std::vector;
+
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    vec4 row(mat4 const &m, int const i) {
+        return vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+
+    vec4 normalizePlane(vec4 const &plane) {
+        return plane / glm::length(vec3(plane));
+    }
+}
+
+// ////////////////////////////////////////////////////// Class: Frustum //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+Frustum::Frustum(mat4 const &viewProjection) {
+    // Gribb-Hartmann plane extraction for clip space z in [-w, w]
+    vec4 const x = row(viewProjection, 0),
+               y = row(viewProjection, 1),
+               z = row(viewProjection, 2),
+               w = row(viewProjection, 3);
+
+    planes[0] = normalizePlane(w + x);
+    planes[1] = normalizePlane(w - x);
+    planes[2] = normalizePlane(w + y);
+    planes[3] = normalizePlane(w - y);
+    planes[4] = normalizePlane(w + z);
+    planes[5] = normalizePlane(w - z);
+}
+
+bool Frustum::intersects(BoundingBox const &box) const {
+    if (box.isEmpty()) {
+        return false;
+    }
+    if (!box.isFinite()) {
+        return true;
+    }
+
+    vec3 const center = box.center();
+    vec3 const extent = box.extent();
+
+    for (auto const &plane : planes) {
+        float const distance = glm::dot(vec3(plane), center) + plane.w;
+        float const radius = glm::dot(glm::abs(vec3(plane)), extent);
+
+        if (distance + radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Frustum::cull(vector<BoundingBox> const &boxes,
+                   vector<char> &visible) const {
+    visible.assign(boxes.size(), 0);
+
+#ifdef FRUSTUM_USE_SSE
+    // '''''''''''''''''''''''''''''''''''' Gather boxes in SoA layout
+    vector<size_t> indices;
+    vector<float> cx, cy, cz, ex, ey, ez;
+
+    indices.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        if (!boxes[i].isFinite()) {
+            visible[i] = intersects(boxes[i]) ? 1 : 0;
+            continue;
+        }
+
+        vec3 const center = boxes[i].center();
+        vec3 const extent = boxes[i].extent();
+
+        indices.push_back(i);
+        cx.push_back(center.x);
+        cy.push_back(center.y);
+        cz.push_back(center.z);
+        ex.push_back(extent.x);
+        ey.push_back(extent.y);
+        ez.push_back(extent.z);
+    }
+
+    // Pad to a multiple of four with degenerate boxes at the origin
+    size_t const count = indices.size();
+    size_t const padded = (count + 3) & ~size_t(3);
+    for (auto *lane : {&cx, &cy, &cz, &ex, &ey, &ez}) {
+        lane->resize(padded, 0.0f);
+    }
+
+    // '''''''''''''''''''''''''''''''''''''''' Test four boxes at a time
+    __m128 const zero = _mm_setzero_ps();
+
+    for (size_t i = 0; i < padded; i += 4) {
+        __m128 const centerX = _mm_loadu_ps(&cx[i]),
+                     centerY = _mm_loadu_ps(&cy[i]),
+                     centerZ = _mm_loadu_ps(&cz[i]),
+                     extentX = _mm_loadu_ps(&ex[i]),
+                     extentY = _mm_loadu_ps(&ey[i]),
+                     extentZ = _mm_loadu_ps(&ez[i]);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+
+        for (auto const &plane : planes) {
+            __m128 const nx = _mm_set1_ps(plane.x),
+                         ny = _mm_set1_ps(plane.y),
+                         nz = _mm_set1_ps(plane.z);
+
+            // distance = n . c + w
+            __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(nx, centerX),
+                               _mm_mul_ps(ny, centerY)),
+                    _mm_add_ps(_mm_mul_ps(nz, centerZ),
+                               _mm_set1_ps(plane.w)));
+
+            // radius = |n| . e
+            __m128 radius = _mm_add_ps(
+                    _mm_add_ps(
+                            _mm_mul_ps(_mm_set1_ps(glm::abs(plane.x)),
+                                       extentX),
+                            _mm_mul_ps(_mm_set1_ps(glm::abs(plane.y)),
+                                       extentY)),
+                    _mm_mul_ps(_mm_set1_ps(glm::abs(plane.z)), extentZ));
+
+            inside = _mm_and_ps(inside,
+                                _mm_cmpge_ps(_mm_add_ps(distance, radius),
+                                             zero));
+        }
+
+        int const mask = _mm_movemask_ps(inside);
+        for (size_t lane = 0; lane < 4 && i + lane < count; ++lane) {
+            visible[indices[i + lane]] = (mask >> lane) & 1;
+        }
+    }
+#else
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        visible[i] = intersects(boxes[i]) ? 1 : 0;
+    }
+#endif
+}
+
+// ///////////////////////////////////////////////////////////////////// //
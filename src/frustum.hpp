@@ -0,0 +1,29 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "bounding-volume.hpp"
+
+#include "glm/glm.hpp"
+
+#include <vector>
+
+// ////////////////////////////////////////////////////// Class: Frustum //
+class Frustum {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    explicit Frustum(glm::mat4 const &viewProjection);
+
+    bool intersects(BoundingBox const &box) const;
+
+    // Tests every box against the frustum, four at a time when SSE is
+    // available; visible[i] is set to 1 if boxes[i] may be visible
+    void cull(std::vector<BoundingBox> const &boxes,
+              std::vector<char> &visible) const;
+
+    // ------------------------------------------------------------ Data --
+    // Left, right, bottom, top, near, far; normals point inwards
+    glm::vec4 planes[6];
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // FRUSTUM_H
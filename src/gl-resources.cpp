@@ -0,0 +1,354 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "gl-resources.hpp"
+#include "frame-stats.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::runtime_error;
+using std::to_string;
+using std::vector;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    // Takes the handle out of a moved-from object
+    resources::Handle take(resources::Handle &handle) {
+        return std::exchange(handle, resources::Handle{});
+    }
+}
+
+namespace gl {
+    // /////////////////////////////////////////////////// Class: Texture //
+    // ================================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    Texture::Texture()
+            : textureTarget(GL_NONE), sizeX(0), sizeY(0),
+              levelsAllocated(0) {
+    }
+
+    Texture::Texture(GLenum const target, int const levels,
+                     GLenum const internalFormat, int const width,
+                     int const height, int const depth,
+                     resources::Category const category)
+            : textureTarget(target), sizeX(width), sizeY(height),
+              levelsAllocated(levels) {
+        GLuint name;
+        glCreateTextures(target, 1, &name);
+        switch (target) {
+            case GL_TEXTURE_2D_ARRAY:
+            case GL_TEXTURE_CUBE_MAP_ARRAY:
+            case GL_TEXTURE_3D:
+                glTextureStorage3D(name, levels, internalFormat, width,
+                                   height, depth);
+                break;
+            default:
+                glTextureStorage2D(name, levels, internalFormat, width,
+                                   height);
+                break;
+        }
+        handle = resources::create(
+                resources::TYPE_TEXTURE, name, category,
+                resources::textureBytes(target, internalFormat, levels,
+                                        width, height, depth));
+    }
+
+    Texture::~Texture() {
+        resources::release(handle);
+    }
+
+    Texture::Texture(Texture &&other) noexcept
+            : handle(take(other.handle)), textureTarget(other.textureTarget),
+              sizeX(other.sizeX), sizeY(other.sizeY),
+              levelsAllocated(other.levelsAllocated) {
+    }
+
+    Texture &Texture::operator=(Texture &&other) noexcept {
+        if (this != &other) {
+            resources::release(handle);
+            handle = take(other.handle);
+            textureTarget = other.textureTarget;
+            sizeX = other.sizeX;
+            sizeY = other.sizeY;
+            levelsAllocated = other.levelsAllocated;
+        }
+        return *this;
+    }
+
+    void Texture::upload(int const level, int const x, int const y,
+                         int const z, int const width, int const height,
+                         int const depth, GLenum const format,
+                         GLenum const type, void const *pixels) {
+        // Cube maps are edited like arrays of six faces
+        if (textureTarget == GL_TEXTURE_2D) {
+            glTextureSubImage2D(id(), level, x, y, width, height, format,
+                                type, pixels);
+        } else {
+            glTextureSubImage3D(id(), level, x, y, z, width, height, depth,
+                                format, type, pixels);
+        }
+    }
+
+    void Texture::parameter(GLenum const pname, GLint const value) {
+        glTextureParameteri(id(), pname, value);
+    }
+
+    void Texture::parameter(GLenum const pname, GLfloat const *values) {
+        glTextureParameterfv(id(), pname, values);
+    }
+
+    void Texture::generateMipmap() {
+        glGenerateTextureMipmap(id());
+    }
+
+    GLuint Texture::id() const {
+        return resources::name(handle);
+    }
+
+    GLenum Texture::target() const {
+        return textureTarget;
+    }
+
+    int Texture::width() const {
+        return sizeX;
+    }
+
+    int Texture::height() const {
+        return sizeY;
+    }
+
+    int Texture::levels() const {
+        return levelsAllocated;
+    }
+
+    int Texture::levelCount(int const width, int const height) {
+        int levels = 1;
+        for (int size = std::max(width, height); size > 1; size /= 2) {
+            ++levels;
+        }
+        return levels;
+    }
+
+    // //////////////////////////////////////////////////// Class: Buffer //
+    // ================================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    Buffer::Buffer() : bytes(0) {
+    }
+
+    Buffer::Buffer(GLsizeiptr const size, void const *data,
+                   GLbitfield const flags,
+                   resources::Category const category)
+            : bytes(size) {
+        GLuint name;
+        glCreateBuffers(1, &name);
+        glNamedBufferStorage(name, size, data, flags);
+        handle = resources::create(resources::TYPE_BUFFER, name, category,
+                                   size);
+    }
+
+    Buffer::~Buffer() {
+        resources::release(handle);
+    }
+
+    Buffer::Buffer(Buffer &&other) noexcept
+            : handle(take(other.handle)), bytes(other.bytes) {
+    }
+
+    Buffer &Buffer::operator=(Buffer &&other) noexcept {
+        if (this != &other) {
+            resources::release(handle);
+            handle = take(other.handle);
+            bytes = other.bytes;
+        }
+        return *this;
+    }
+
+    void Buffer::update(GLintptr const offset, GLsizeiptr const size,
+                        void const *data) {
+        stats::current().bufferUploads++;
+        stats::current().bufferUploadBytes += size;
+        glNamedBufferSubData(id(), offset, size, data);
+    }
+
+    GLuint Buffer::id() const {
+        return resources::name(handle);
+    }
+
+    GLsizeiptr Buffer::size() const {
+        return bytes;
+    }
+
+    // /////////////////////////////////////////////// Class: VertexArray //
+    // ================================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    VertexArray::VertexArray() = default;
+
+    VertexArray::~VertexArray() {
+        resources::release(handle);
+    }
+
+    VertexArray VertexArray::create() {
+        GLuint name;
+        glCreateVertexArrays(1, &name);
+        VertexArray vertexArray;
+        vertexArray.handle = resources::create(
+                resources::TYPE_VERTEX_ARRAY, name,
+                resources::CATEGORY_STATE, 0);
+        return vertexArray;
+    }
+
+    VertexArray::VertexArray(VertexArray &&other) noexcept
+            : handle(take(other.handle)) {
+    }
+
+    VertexArray &VertexArray::operator=(VertexArray &&other) noexcept {
+        if (this != &other) {
+            resources::release(handle);
+            handle = take(other.handle);
+        }
+        return *this;
+    }
+
+    void VertexArray::vertexBuffer(GLuint const binding,
+                                   Buffer const &buffer,
+                                   GLsizei const stride,
+                                   GLintptr const offset) {
+        vertexBuffer(binding, buffer.id(), stride, offset);
+    }
+
+    void VertexArray::vertexBuffer(GLuint const binding, GLuint const buffer,
+                                   GLsizei const stride,
+                                   GLintptr const offset) {
+        glVertexArrayVertexBuffer(id(), binding, buffer, offset, stride);
+    }
+
+    void VertexArray::elementBuffer(Buffer const &buffer) {
+        glVertexArrayElementBuffer(id(), buffer.id());
+    }
+
+    void VertexArray::attribute(GLuint const index, GLuint const binding,
+                                GLint const size, GLenum const type,
+                                bool const normalized,
+                                GLuint const offset) {
+        glEnableVertexArrayAttrib(id(), index);
+        glVertexArrayAttribFormat(id(), index, size, type,
+                                  normalized ? GL_TRUE : GL_FALSE, offset);
+        glVertexArrayAttribBinding(id(), index, binding);
+    }
+
+    void VertexArray::bind() const {
+        glBindVertexArray(id());
+    }
+
+    GLuint VertexArray::id() const {
+        return resources::name(handle);
+    }
+
+    // ////////////////////////////////////////////// Class: Renderbuffer //
+    // ================================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    Renderbuffer::Renderbuffer() = default;
+
+    Renderbuffer::Renderbuffer(GLenum const internalFormat, int const width,
+                               int const height, int const samples,
+                               resources::Category const category) {
+        GLuint name;
+        glCreateRenderbuffers(1, &name);
+        glNamedRenderbufferStorageMultisample(name, samples, internalFormat,
+                                              width, height);
+        handle = resources::create(
+                resources::TYPE_RENDERBUFFER, name, category,
+                resources::textureBytes(GL_TEXTURE_2D, internalFormat, 1,
+                                        width, height, 1) *
+                std::max(samples, 1));
+    }
+
+    Renderbuffer::~Renderbuffer() {
+        resources::release(handle);
+    }
+
+    Renderbuffer::Renderbuffer(Renderbuffer &&other) noexcept
+            : handle(take(other.handle)) {
+    }
+
+    Renderbuffer &Renderbuffer::operator=(Renderbuffer &&other) noexcept {
+        if (this != &other) {
+            resources::release(handle);
+            handle = take(other.handle);
+        }
+        return *this;
+    }
+
+    GLuint Renderbuffer::id() const {
+        return resources::name(handle);
+    }
+
+    // /////////////////////////////////////////////// Class: Framebuffer //
+    // ================================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    Framebuffer::Framebuffer() = default;
+
+    Framebuffer::~Framebuffer() {
+        resources::release(handle);
+    }
+
+    Framebuffer Framebuffer::create() {
+        GLuint name;
+        glCreateFramebuffers(1, &name);
+        Framebuffer framebuffer;
+        framebuffer.handle = resources::create(
+                resources::TYPE_FRAMEBUFFER, name,
+                resources::CATEGORY_STATE, 0);
+        return framebuffer;
+    }
+
+    Framebuffer::Framebuffer(Framebuffer &&other) noexcept
+            : handle(take(other.handle)) {
+    }
+
+    Framebuffer &Framebuffer::operator=(Framebuffer &&other) noexcept {
+        if (this != &other) {
+            resources::release(handle);
+            handle = take(other.handle);
+        }
+        return *this;
+    }
+
+    void Framebuffer::attach(GLenum const attachment,
+                             Texture const &texture, int const level) {
+        glNamedFramebufferTexture(id(), attachment, texture.id(), level);
+    }
+
+    void Framebuffer::attach(GLenum const attachment,
+                             Renderbuffer const &renderbuffer) {
+        glNamedFramebufferRenderbuffer(id(), attachment, GL_RENDERBUFFER,
+                                       renderbuffer.id());
+    }
+
+    void Framebuffer::drawBuffers(vector<GLenum> const &buffers) {
+        glNamedFramebufferDrawBuffers(id(),
+                                      static_cast<GLsizei>(buffers.size()),
+                                      buffers.data());
+    }
+
+    void Framebuffer::readBuffer(GLenum const buffer) {
+        glNamedFramebufferReadBuffer(id(), buffer);
+    }
+
+    void Framebuffer::check() const {
+        GLenum const status =
+                glCheckNamedFramebufferStatus(id(), GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            throw runtime_error("Framebuffer incomplete: " +
+                                to_string(status) + "!");
+        }
+    }
+
+    GLuint Framebuffer::id() const {
+        return resources::name(handle);
+    }
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,208 @@
+#ifndef GL_RESOURCES_H
+#define GL_RESOURCES_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "opengl-headers.hpp"
+#include "resource-manager.hpp"
+
+#include <vector>
+
+// ///////////////////////////////////////////////////////// GL resources //
+// Owners of OpenGL objects, created and edited through direct state
+// access (OpenGL 4.5), so neither creation nor updates touch the current
+// bindings. Textures and buffers get immutable storage when they are
+// constructed: the driver knows their final size and usage up front and
+// can place them accordingly. Objects move but don't copy; a moved-from
+// or default-constructed one holds name 0, needs no context and deletes
+// nothing. Vertex arrays and framebuffers have no storage to size, so
+// theirs come from create(). Every
+// object is registered with the resource manager, which deletes it once
+// the GPU is done with the frame that released it.
+namespace gl {
+    // /////////////////////////////////////////////////// Class: Texture //
+    class Texture {
+    public: // ======================================== Public interface ==
+        // --------------------------------------------------- Behaviour --
+        Texture();
+
+        // Allocates every level of a 2D texture, cube map (depth 1) or
+        // array (depth layers, six per cube for cube map arrays)
+        Texture(GLenum const target, int const levels,
+                GLenum const internalFormat, int const width,
+                int const height, int const depth = 1,
+                resources::Category const category =
+                        resources::CATEGORY_TEXTURES);
+
+        ~Texture();
+
+        Texture(Texture &&other) noexcept;
+        Texture &operator=(Texture &&other) noexcept;
+
+        Texture(Texture const &) = delete;
+        Texture &operator=(Texture const &) = delete;
+
+        // Replaces a region of one level; for cube maps and arrays
+        // z selects the first face or layer
+        void upload(int const level, int const x, int const y, int const z,
+                    int const width, int const height, int const depth,
+                    GLenum const format, GLenum const type,
+                    void const *pixels);
+
+        void parameter(GLenum const pname, GLint const value);
+        void parameter(GLenum const pname, GLfloat const *values);
+
+        void generateMipmap();
+
+        GLuint id() const;
+        GLenum target() const;
+        int width() const;
+        int height() const;
+        int levels() const;
+
+        // Levels of a full mip chain down to 1x1
+        static int levelCount(int const width, int const height);
+
+    private: // ================================= Private implementation ==
+        // -------------------------------------------------------- Data --
+        resources::Handle handle;
+        GLenum textureTarget;
+        int sizeX, sizeY, levelsAllocated;
+    };
+
+    // //////////////////////////////////////////////////// Class: Buffer //
+    class Buffer {
+    public: // ======================================== Public interface ==
+        // --------------------------------------------------- Behaviour --
+        Buffer();
+
+        // flags as for glBufferStorage; contents are only replaceable with
+        // update() under GL_DYNAMIC_STORAGE_BIT
+        Buffer(GLsizeiptr const size, void const *data,
+               GLbitfield const flags = 0,
+               resources::Category const category =
+                       resources::CATEGORY_GEOMETRY);
+
+        ~Buffer();
+
+        Buffer(Buffer &&other) noexcept;
+        Buffer &operator=(Buffer &&other) noexcept;
+
+        Buffer(Buffer const &) = delete;
+        Buffer &operator=(Buffer const &) = delete;
+
+        void update(GLintptr const offset, GLsizeiptr const size,
+                    void const *data);
+
+        GLuint id() const;
+        GLsizeiptr size() const;
+
+    private: // ================================= Private implementation ==
+        // -------------------------------------------------------- Data --
+        resources::Handle handle;
+        GLsizeiptr bytes;
+    };
+
+    // /////////////////////////////////////////////// Class: VertexArray //
+    class VertexArray {
+    public: // ======================================== Public interface ==
+        // --------------------------------------------------- Behaviour --
+        VertexArray();
+        ~VertexArray();
+
+        static VertexArray create();
+
+        VertexArray(VertexArray &&other) noexcept;
+        VertexArray &operator=(VertexArray &&other) noexcept;
+
+        VertexArray(VertexArray const &) = delete;
+        VertexArray &operator=(VertexArray const &) = delete;
+
+        // Feeds binding point binding from buffer, stride bytes apart
+        void vertexBuffer(GLuint const binding, Buffer const &buffer,
+                          GLsizei const stride, GLintptr const offset = 0);
+
+        // Same for a buffer owned elsewhere, such as the StreamBuffer
+        void vertexBuffer(GLuint const binding, GLuint const buffer,
+                          GLsizei const stride, GLintptr const offset);
+
+        void elementBuffer(Buffer const &buffer);
+
+        // Enables attribute index, read from binding at offset bytes into
+        // each vertex
+        void attribute(GLuint const index, GLuint const binding,
+                       GLint const size, GLenum const type,
+                       bool const normalized, GLuint const offset);
+
+        void bind() const;
+
+        GLuint id() const;
+
+    private: // ================================= Private implementation ==
+        // -------------------------------------------------------- Data --
+        resources::Handle handle;
+    };
+
+    // ////////////////////////////////////////////// Class: Renderbuffer //
+    class Renderbuffer {
+    public: // ======================================== Public interface ==
+        // --------------------------------------------------- Behaviour --
+        Renderbuffer();
+
+        // Multisampled unless samples is 0; for attachments that are
+        // only drawn to and blitted from, never sampled
+        Renderbuffer(GLenum const internalFormat, int const width,
+                     int const height, int const samples = 0,
+                     resources::Category const category =
+                             resources::CATEGORY_TARGETS);
+
+        ~Renderbuffer();
+
+        Renderbuffer(Renderbuffer &&other) noexcept;
+        Renderbuffer &operator=(Renderbuffer &&other) noexcept;
+
+        Renderbuffer(Renderbuffer const &) = delete;
+        Renderbuffer &operator=(Renderbuffer const &) = delete;
+
+        GLuint id() const;
+
+    private: // ================================= Private implementation ==
+        // -------------------------------------------------------- Data --
+        resources::Handle handle;
+    };
+
+    // /////////////////////////////////////////////// Class: Framebuffer //
+    class Framebuffer {
+    public: // ======================================== Public interface ==
+        // --------------------------------------------------- Behaviour --
+        Framebuffer();
+        ~Framebuffer();
+
+        static Framebuffer create();
+
+        Framebuffer(Framebuffer &&other) noexcept;
+        Framebuffer &operator=(Framebuffer &&other) noexcept;
+
+        Framebuffer(Framebuffer const &) = delete;
+        Framebuffer &operator=(Framebuffer const &) = delete;
+
+        void attach(GLenum const attachment, Texture const &texture,
+                    int const level = 0);
+        void attach(GLenum const attachment,
+                    Renderbuffer const &renderbuffer);
+
+        // GL_NONE alone for depth-only targets
+        void drawBuffers(std::vector<GLenum> const &buffers);
+        void readBuffer(GLenum const buffer);
+
+        // Throws unless the attachments form a complete framebuffer
+        void check() const;
+
+        GLuint id() const;
+
+    private: // ================================= Private implementation ==
+        // -------------------------------------------------------- Data --
+        resources::Handle handle;
+    };
+}
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // GL_RESOURCES_H
@@ -0,0 +1,224 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "headless-context.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::ofstream;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+#ifdef FIFTH_PARAGRAPH_EGL
+namespace {
+    // From EGL_MESA_platform_surfaceless
+    EGLenum const PLATFORM_SURFACELESS_MESA = 0x31DD;
+
+    using GetPlatformDisplay = EGLDisplay (*)(EGLenum, void *,
+                                              EGLint const *);
+
+    EGLDisplay openDisplay() {
+        // Prefer a display that needs neither X11 nor a GPU
+        auto const getPlatformDisplay = reinterpret_cast<GetPlatformDisplay>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay) {
+            EGLDisplay const display = getPlatformDisplay(
+                    PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY &&
+                eglInitialize(display, nullptr, nullptr)) {
+                return display;
+            }
+        }
+
+        EGLDisplay const display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY ||
+            !eglInitialize(display, nullptr, nullptr)) {
+            throw runtime_error("Failed to initialize EGL display!");
+        }
+        return display;
+    }
+}
+#endif
+
+// ///////////////////////////////////////////// Class: HeadlessContext //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+HeadlessContext::HeadlessContext(int const width, int const height,
+                                 int const samples)
+        : width(width), height(height) {
+    createContext();
+    createFramebuffers(samples);
+}
+
+HeadlessContext::~HeadlessContext() {
+    glDeleteFramebuffers(1, &resolveFBO);
+    glDeleteFramebuffers(1, &multisampleFBO);
+    glDeleteRenderbuffers(1, &resolveRenderbuffer);
+    glDeleteRenderbuffers(1, &depthRenderbuffer);
+    glDeleteRenderbuffers(1, &colorRenderbuffer);
+
+#ifdef FIFTH_PARAGRAPH_EGL
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+    }
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+#endif
+}
+
+GLuint HeadlessContext::framebuffer() const {
+    return multisampleFBO;
+}
+
+vector<unsigned char> HeadlessContext::readFrame() const {
+    // Resolve samples into the single-sampled framebuffer
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, multisampleFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    // Read pixels back, bottom row first
+    vector<unsigned char> pixels(3 * width * height);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, resolveFBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE,
+                 pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, multisampleFBO);
+
+    // Flip to top row first
+    size_t const stride = 3 * width;
+    vector<unsigned char> row(stride);
+    for (int y = 0; y < height / 2; ++y) {
+        unsigned char *top = &pixels[y * stride];
+        unsigned char *bottom = &pixels[(height - 1 - y) * stride];
+        std::memcpy(row.data(), top, stride);
+        std::memcpy(top, bottom, stride);
+        std::memcpy(bottom, row.data(), stride);
+    }
+
+    return pixels;
+}
+
+void HeadlessContext::saveFrame(string const &filename) const {
+    vector<unsigned char> const pixels = readFrame();
+
+    ofstream file(filename, std::ios::binary);
+    if (!file) {
+        throw runtime_error("Couldn't write " + filename);
+    }
+
+    file << "P6\n" << width << ' ' << height << "\n255\n";
+    file.write(reinterpret_cast<char const *>(pixels.data()),
+               pixels.size());
+}
+
+// ============================================== Private implementation ==
+// ----------------------------------------------------------- Behaviour --
+void HeadlessContext::createContext() {
+#ifdef FIFTH_PARAGRAPH_EGL
+    display = openDisplay();
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        throw runtime_error("EGL: desktop OpenGL is not supported!");
+    }
+
+    // Choose configuration
+    EGLint const configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1,
+                         &configCount) || configCount == 0) {
+        throw runtime_error("EGL: no suitable configuration!");
+    }
+
+    // Create OpenGL 4.5 core context
+    EGLint const contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 4,
+            EGL_CONTEXT_MINOR_VERSION, 5,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK,
+            EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT,
+                               contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        throw runtime_error("EGL: failed to create OpenGL 4.5 context!");
+    }
+
+    // Surfaceless if supported, otherwise a tiny pbuffer to bind to
+    surface = EGL_NO_SURFACE;
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                        context)) {
+        EGLint const surfaceAttributes[] = {
+                EGL_WIDTH, 1,
+                EGL_HEIGHT, 1,
+                EGL_NONE
+        };
+        surface = eglCreatePbufferSurface(display, config,
+                                          surfaceAttributes);
+        if (surface == EGL_NO_SURFACE ||
+            !eglMakeCurrent(display, surface, surface, context)) {
+            throw runtime_error("EGL: failed to make context current!");
+        }
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc) eglGetProcAddress)) {
+        throw runtime_error("Failed to initialize OpenGL loader!");
+    }
+#else
+    throw runtime_error("Headless rendering needs EGL, which was not "
+                        "available when this program was built!");
+#endif
+}
+
+void HeadlessContext::createFramebuffers(int const samples) {
+    // Multisampled target that stands in for the window
+    glGenRenderbuffers(1, &colorRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRenderbuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8,
+                                     width, height);
+
+    glGenRenderbuffers(1, &depthRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
+                                     GL_DEPTH24_STENCIL8, width, height);
+
+    glGenFramebuffers(1, &multisampleFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, multisampleFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, colorRenderbuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                              GL_RENDERBUFFER, depthRenderbuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+        GL_FRAMEBUFFER_COMPLETE) {
+        throw runtime_error("Headless framebuffer is incomplete!");
+    }
+
+    // Single-sampled target for reading frames back
+    glGenRenderbuffers(1, &resolveRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolveRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenFramebuffers(1, &resolveFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, resolveRenderbuffer);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, multisampleFBO);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,57 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "opengl-headers.hpp"
+
+#ifdef FIFTH_PARAGRAPH_EGL
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#endif
+
+#include <string>
+#include <vector>
+
+// ///////////////////////////////////////////// Class: HeadlessContext //
+// OpenGL 4.5 core context without a window (EGL, surfaceless or pbuffer
+// on Mesa). Everything that would go to the window is rendered into an
+// offscreen multisampled framebuffer instead.
+class HeadlessContext {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    HeadlessContext(int const width, int const height, int const samples);
+    ~HeadlessContext();
+
+    HeadlessContext(HeadlessContext const &) = delete;
+    HeadlessContext &operator=(HeadlessContext const &) = delete;
+
+    // Framebuffer that takes the place of the window's default one
+    GLuint framebuffer() const;
+
+    // Resolves the frame and reads it back as tightly packed RGB rows,
+    // top row first
+    std::vector<unsigned char> readFrame() const;
+
+    // Writes the current frame as a binary PPM image
+    void saveFrame(std::string const &filename) const;
+
+    // ------------------------------------------------------------ Data --
+    int const width, height;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------- Behaviour --
+    void createContext();
+    void createFramebuffers(int const samples);
+
+    // ------------------------------------------------------------ Data --
+#ifdef FIFTH_PARAGRAPH_EGL
+    EGLDisplay display;
+    EGLContext context;
+    EGLSurface surface;
+#endif
+
+    GLuint multisampleFBO, colorRenderbuffer, depthRenderbuffer;
+    GLuint resolveFBO, resolveRenderbuffer;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // HEADLESS_CONTEXT_H
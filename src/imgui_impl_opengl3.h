@@ -32,6 +32,10 @@ IMGUI_IMPL_API void     ImGui_ImplOpenGL3_Shutdown();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_NewFrame();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data);
 
+// Stream vertices and indices through the application's persistently mapped ring instead of re-specifying buffers per draw list (NULL to go back)
+class StreamBuffer;
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_SetStreamBuffer(StreamBuffer* stream_buffer);
+
 // Called by Init/NewFrame/Shutdown
 IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_CreateFontsTexture();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyFontsTexture();
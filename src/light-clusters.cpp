@@ -0,0 +1,126 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "light-clusters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::to_string;
+using std::vector;
+
+// //////////////////////////////////////////////// Class: LightClusters //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+LightClusters::LightClusters(shared_ptr<StreamBuffer> stream)
+        : assignShader(make_shared<Shader>(
+                  "res/shaders/clusters/compute.glsl", defines())),
+          stream(std::move(stream)), lightsAllocation{0, 0, nullptr},
+          lightsSize(0),
+          // Written by the compute pass only, never read back
+          countsBuffer(CLUSTER_COUNT * sizeof(GLuint), nullptr, 0,
+                       resources::CATEGORY_TARGETS),
+          indicesBuffer(CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER *
+                        sizeof(GLuint), nullptr, 0,
+                        resources::CATEGORY_TARGETS),
+          count(0), near(0.1f), far(100.0f), width(1), height(1) {
+}
+
+ShaderDefines LightClusters::defines() {
+    return {{"CLUSTER_GRID_X", to_string(GRID_X)},
+            {"CLUSTER_GRID_Y", to_string(GRID_Y)},
+            {"CLUSTER_GRID_Z", to_string(GRID_Z)},
+            {"CLUSTER_MAX_LIGHTS", to_string(MAX_LIGHTS_PER_CLUSTER)}};
+}
+
+float LightClusters::range(float const constant, float const linear,
+                           float const quadratic, float const brightness) {
+    // Solve constant + linear d + quadratic d^2 = 256 brightness
+    float const target = 256.0f * brightness - constant;
+    if (target <= 0.0f) {
+        return 0.0f;
+    }
+    if (quadratic > 0.0f) {
+        return (-linear + std::sqrt(linear * linear +
+                                    4.0f * quadratic * target)) /
+               (2.0f * quadratic);
+    }
+    if (linear > 0.0f) {
+        return target / linear;
+    }
+
+    // No falloff, the light reaches every cluster
+    return 1.0e6f;
+}
+
+void LightClusters::update(vector<ClusterLight> const &lights,
+                           glm::mat4 const &view,
+                           glm::mat4 const &projection,
+                           float const near, float const far,
+                           int const width, int const height) {
+    count = std::min(static_cast<int>(lights.size()), MAX_LIGHTS);
+    this->near = near;
+    this->far = far;
+    this->width = std::max(width, 1);
+    this->height = std::max(height, 1);
+
+    // At least one entry, an empty range can't be bound
+    lightsSize = std::max(count, 1) * sizeof(ClusterLight);
+    lightsAllocation = stream->allocate(lightsSize,
+                                        stream->storageAlignment());
+    std::copy(lights.begin(), lights.begin() + count,
+              static_cast<ClusterLight *>(lightsAllocation.data));
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, LIGHTS_BINDING,
+                      lightsAllocation.buffer, lightsAllocation.offset,
+                      lightsSize);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNTS_BINDING,
+                     countsBuffer.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INDICES_BINDING,
+                     indicesBuffer.id());
+
+    // One invocation per cluster, one work group per depth slice
+    assignShader->use();
+    assignShader->uniformMatrix4fv("view", glm::value_ptr(view));
+    assignShader->uniformMatrix4fv(
+            "inverseProjection",
+            glm::value_ptr(glm::inverse(projection)));
+    assignShader->uniform2f("clusterDepthRange", near, far);
+    assignShader->uniform1i("clusterLightCount", count);
+    glDispatchCompute(1, 1, GRID_Z);
+
+    // Lists are read by fragment shaders of the following draws
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void LightClusters::setShaderParameters(
+        shared_ptr<Shader> const &shader) const {
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, LIGHTS_BINDING,
+                      lightsAllocation.buffer, lightsAllocation.offset,
+                      lightsSize);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNTS_BINDING,
+                     countsBuffer.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INDICES_BINDING,
+                     indicesBuffer.id());
+
+    shader->uniform2f("clusterDepthRange", near, far);
+    shader->uniform2f("clusterTileSize",
+                      static_cast<float>(width) / GRID_X,
+                      static_cast<float>(height) / GRID_Y);
+}
+
+int LightClusters::lightCount() const {
+    return count;
+}
+
+shared_ptr<Shader> const &LightClusters::shader() const {
+    return assignShader;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,88 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "gl-resources.hpp"
+#include "opengl-headers.hpp"
+#include "shader.hpp"
+#include "stream-buffer.hpp"
+
+#include <memory>
+#include <vector>
+
+// //////////////////////////////////////////////// Struct: ClusterLight //
+// One point or spot light as laid out in the lights buffer (std430)
+struct ClusterLight {
+    glm::vec4 position;     // xyz, w: range of influence
+    glm::vec4 direction;    // xyz, w: spot angle, negative for point lights
+    glm::vec4 attenuation;  // constant, linear, quadratic, enable
+    glm::vec4 ambient;      // rgb, intensity
+    glm::vec4 diffuse;      // rgb, intensity
+    glm::vec4 specular;     // rgb, intensity
+    glm::vec4 shininess;    // x: specular shininess
+};
+
+// //////////////////////////////////////////////// Class: LightClusters //
+// Clustered forward lighting: a compute pass splits the view frustum into
+// GRID_X x GRID_Y screen tiles and GRID_Z exponential depth slices, and
+// lists the lights whose range touches each cluster. Fragments then only
+// visit the lights of their own cluster.
+class LightClusters {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    static constexpr int GRID_X = 16;
+    static constexpr int GRID_Y = 9;
+    static constexpr int GRID_Z = 24;
+    static constexpr int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    static constexpr int MAX_LIGHTS = 1024;
+    static constexpr int MAX_LIGHTS_PER_CLUSTER = 64;
+
+    // Shader storage bindings shared with res/shaders/include/clusters.glsl
+    static constexpr int LIGHTS_BINDING = 0;
+    static constexpr int COUNTS_BINDING = 1;
+    static constexpr int INDICES_BINDING = 2;
+
+    // ------------------------------------------------------- Behaviour --
+    // Lights are streamed through the StreamBuffer every frame
+    explicit LightClusters(std::shared_ptr<StreamBuffer> stream);
+
+    LightClusters(LightClusters const &) = delete;
+    LightClusters &operator=(LightClusters const &) = delete;
+
+    // Grid dimensions for shaders that include clusters.glsl
+    static ShaderDefines defines();
+
+    // Distance at which a light with this attenuation falls below 1/256
+    // of its brightest colour channel
+    static float range(float const constant, float const linear,
+                       float const quadratic, float const brightness);
+
+    // Uploads the lights and rebuilds the per-cluster lists; lights past
+    // MAX_LIGHTS are dropped
+    void update(std::vector<ClusterLight> const &lights,
+                glm::mat4 const &view, glm::mat4 const &projection,
+                float const near, float const far,
+                int const width, int const height);
+
+    // Binds the buffers and sets the lookup uniforms of a lit shader
+    void setShaderParameters(std::shared_ptr<Shader> const &shader) const;
+
+    int lightCount() const;
+
+    std::shared_ptr<Shader> const &shader() const;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------------ Data --
+    std::shared_ptr<Shader> const assignShader;
+    std::shared_ptr<StreamBuffer> const stream;
+    StreamBuffer::Allocation lightsAllocation;
+    GLsizeiptr lightsSize;
+    gl::Buffer countsBuffer, indicesBuffer;
+
+    int count;
+    float near, far;
+    int width, height;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // LIGHT_CLUSTERS_H
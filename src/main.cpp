@@ -1,20 +1,46 @@
 // //////////////////////////////////////////////////////////// Includes //
 #include "model.hpp"
 #include "skybox.hpp"
+#include "frustum.hpp"
 #include "opengl-headers.hpp"
 #include "shader.hpp"
+#include "shader-permutations.hpp"
+#include "light-clusters.hpp"
+#include "draw-data.hpp"
+#include "stream-buffer.hpp"
+#include "environment-lighting.hpp"
+#include "post-processing.hpp"
+#include "dynamic-resolution.hpp"
 #include "shadow-map.hpp"
 #include "font.hpp"
-
+#include "profiler.hpp"
+#include "frame-stats.hpp"
+#include "resource-manager.hpp"
+#include "benchmark.hpp"
+#include "headless-context.hpp"
+#include "regression.hpp"
+#include "file-watcher.hpp"
+#include "triple-buffer.hpp"
+
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cfloat>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <exception>
+#include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <sstream>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 using sysclock = std::chrono::system_clock;
@@ -35,16 +61,25 @@ using glm::vec2;
 using glm::vec3;
 
 using std::array;
+using std::atomic;
 using std::begin;
 using std::cerr;
+using std::condition_variable;
+using std::copy;
 using std::end;
 using std::endl;
 using std::exception;
+using std::exception_ptr;
+using std::lock_guard;
 using std::make_shared;
 using std::make_unique;
+using std::mutex;
+using std::runtime_error;
 using std::shared_ptr;
 using std::string;
 using std::stringstream;
+using std::thread;
+using std::unique_lock;
 using std::unique_ptr;
 using std::vector;
 
@@ -63,6 +98,7 @@ bool menu = true;
 // //////////////////////////////////////////////////////// Game objects //
 struct Block {
     bool render;
+    float flash;
     vec3 position;
     vec2 dimensions;
     shared_ptr<Renderable> model;
@@ -70,6 +106,7 @@ struct Block {
 
     Block(shared_ptr<Shader> const &shader) {
         render = true;
+        flash = 0.0f;
         position = vec3(0.0f, 0.0f, 0.0f);
         dimensions = vec2(4.0f, 1.0f);
         model = nullptr;
@@ -77,6 +114,12 @@ struct Block {
         transform = mat4(1.0f);
     }
 
+    // The light of a hit block dies out over FLASH_DURATION seconds
+    void fade(float const deltaTime) {
+        static float const FLASH_DURATION = 0.5f;
+        flash = glm::max(flash - deltaTime / FLASH_DURATION, 0.0f);
+    }
+
     static vector<shared_ptr<Block>>
     generateBlocks(shared_ptr<Shader> const &shader, int const x,
                    int const y) {
@@ -114,12 +157,14 @@ struct Block {
 
 struct Palette {
     vec3 position;
+    vec3 previousPosition;
     vec3 positionTarget;
     vec2 dimensions;
     shared_ptr<Renderable> model, modelBig, modelSmall;
 
     Palette(shared_ptr<Shader> const &shader) {
         position = vec3(0.0f, 0.0f, -25.0f);
+        previousPosition = position;
         positionTarget = vec3(0.0f, 0.0f, -25.0f);
         modelBig = make_shared<Model>("res/models/palette-big.obj");
         modelSmall = make_shared<Model>("res/models/palette-small.obj");
@@ -142,6 +187,7 @@ struct Palette {
 struct Ball {
     bool sticky;
     vec3 position;
+    vec3 previousPosition;
     vec3 direction;
     float speed;
     vec3 positionTarget;
@@ -153,6 +199,7 @@ struct Ball {
         sticky = true;
         position = palette->position +
                    vec3(0.0f, 0.0f, palette->dimensions.y);
+        previousPosition = position;
         direction = vec3(0.05f, 0.0f, 1.0f);
         speed = 20.0f;
         positionTarget = vec3(0.0f, 0.0f, -25.0f);
@@ -228,11 +275,11 @@ struct Ball {
             if (collisionDirection.y == 0.0f) {
                 direction.x = -direction.x;
                 position.x += collisionDirection.x * (radius -
-                                                      abs(collisionDirection.x));
+                                                      glm::abs(collisionDirection.x));
             } else {
                 direction.z = 1.0f;
                 position.z += collisionDirection.y * (radius -
-                                                      abs(collisionDirection.y));
+                                                      glm::abs(collisionDirection.y));
 
                 direction.x = (position.x - palette->position.x) /
                               (palette->dimensions.x / 2.0f);
@@ -258,6 +305,7 @@ struct Ball {
             }
 
             block->render = false;
+            block->flash = 1.0f;
             cameraPosTarget -= cameraNudge * direction;
             points++;
             blocksDestroyed++;
@@ -288,11 +336,11 @@ struct Ball {
             if (collisionDirection.y == 0.0f) {
                 direction.x = -direction.x;
                 position.x += collisionDirection.x * (radius -
-                                                      abs(collisionDirection.x));
+                                                      glm::abs(collisionDirection.x));
             } else {
                 direction.z = -direction.z;
                 position.z += collisionDirection.y * (radius -
-                                                      abs(collisionDirection.y));
+                                                      glm::abs(collisionDirection.y));
             }
 
             break;
@@ -315,6 +363,7 @@ T lerp(T a, T b, float alpha) {
 // //////////////////////////////////////////////// Additional variables //
 
 bool pbrEnabled = true;
+bool shadowsEnabled = true;
 bool quitProgram = false;
 
 // ///////////////////////////////////////////////////////// Conversions //
@@ -352,32 +401,62 @@ struct LightParameters {
     ImVec4 specularColor;
     float specularShininess;
 
-    void setShaderParameters(shared_ptr<Shader> shader) {
-//        shader->uniform1i("pbrEnabled", (int) pbrEnabled);
-//
-//        shader->uniform1f(name + ".enable", enable);
-//
-        shader->uniform3f(name + ".direction",
+    void setShaderParameters(shared_ptr<Shader> const &shader,
+                             string const &uniformName) const {
+        shader->uniform1f(uniformName + ".enable", enable);
+
+        shader->uniform3f(uniformName + ".direction",
                           glm::normalize(ImVec4ToVec3(direction)));
-//        shader->uniform3f(name + ".position", ImVec4ToVec3(position));
-//        shader->uniform1f(name + ".angle", angle);
-//
-//        shader->uniform1f(name + ".attenuationConstant",
-//                          attenuationConstant);
-//        shader->uniform1f(name + ".attenuationLinear", attenuationLinear);
-//        shader->uniform1f(name + ".attenuationQuadratic",
-//                          attenuationQuadratic);
-//
-//        shader->uniform1f(name + ".ambientIntensity", ambientIntensity);
-//        shader->uniform3f(name + ".ambientColor",
-//                          ImVec4ToVec3(ambientColor));
-//        shader->uniform1f(name + ".diffuseIntensity", diffuseIntensity);
-        shader->uniform3f(name + ".diffuseColor",
+        shader->uniform3f(uniformName + ".position",
+                          ImVec4ToVec3(position));
+        shader->uniform1f(uniformName + ".angle", angle);
+
+        shader->uniform1f(uniformName + ".attenuationConstant",
+                          attenuationConstant);
+        shader->uniform1f(uniformName + ".attenuationLinear",
+                          attenuationLinear);
+        shader->uniform1f(uniformName + ".attenuationQuadratic",
+                          attenuationQuadratic);
+
+        shader->uniform1f(uniformName + ".ambientIntensity",
+                          ambientIntensity);
+        shader->uniform3f(uniformName + ".ambientColor",
+                          ImVec4ToVec3(ambientColor));
+        shader->uniform1f(uniformName + ".diffuseIntensity",
+                          diffuseIntensity);
+        shader->uniform3f(uniformName + ".diffuseColor",
                           ImVec4ToVec3(diffuseColor));
-//        shader->uniform1f(name + ".specularIntensity", specularIntensity);
-//        shader->uniform3f(name + ".specularColor",
-//                          ImVec4ToVec3(specularColor));
-//        shader->uniform1f(name + ".specularShininess", specularShininess);
+        shader->uniform1f(uniformName + ".specularIntensity",
+                          specularIntensity);
+        shader->uniform3f(uniformName + ".specularColor",
+                          ImVec4ToVec3(specularColor));
+        shader->uniform1f(uniformName + ".specularShininess",
+                          specularShininess);
+    }
+
+    ClusterLight clusterLight() const {
+        float brightness = 0.0f;
+        for (vec3 const &color : {
+                ambientIntensity * ImVec4ToVec3(ambientColor),
+                ImVec4ToVec3(diffuseColor),
+                diffuseIntensity * ImVec4ToVec3(diffuseColor),
+                specularIntensity * ImVec4ToVec3(specularColor)}) {
+            brightness = std::max({brightness, color.x, color.y, color.z});
+        }
+
+        return {glm::vec4(ImVec4ToVec3(position),
+                          LightClusters::range(attenuationConstant,
+                                               attenuationLinear,
+                                               attenuationQuadratic,
+                                               enable * brightness)),
+                glm::vec4(glm::normalize(ImVec4ToVec3(direction)),
+                          type == LT_SPOT ? angle : -1.0f),
+                glm::vec4(attenuationConstant, attenuationLinear,
+                          attenuationQuadratic, enable),
+                glm::vec4(ImVec4ToVec3(ambientColor), ambientIntensity),
+                glm::vec4(ImVec4ToVec3(diffuseColor), diffuseIntensity),
+                glm::vec4(ImVec4ToVec3(specularColor), specularIntensity),
+                glm::vec4(specularShininess, 0.0f, 0.0f, 0.0f)};
     }
 };
 
@@ -451,9 +530,84 @@ LightParameters lightSpot2 = {
         {1.0, 1.0, 1.0, 1.0},
         256.0};
 
+// Template for the light of a block that was just hit; position and
+// enable are set per block
+LightParameters lightBlockFlash = {
+        "lightBlockFlash",
+        LT_POINT,
+        1.0,
+        {0.0, -1.0, 0.0, 1.0},
+        {0.0, 0.0, 0.0, 1.0},
+        radians(0.0),
+        1.0,
+        0.0,
+        4.0,
+        0.0,
+        {1.0, 1.0, 1.0, 1.0},
+        1.0,
+        {2.0, 1.2, 0.5, 1.0},
+        1.0,
+        {1.0, 1.0, 1.0, 1.0},
+        256.0};
+
+// Lights of the blocks still flashing after a hit
+void gatherFlashLights(vector<shared_ptr<Block>> const &blocks,
+                       vector<ClusterLight> &lights) {
+    lights.clear();
+    for (auto const &block : blocks) {
+        if (block->flash > 0.0f) {
+            LightParameters light = lightBlockFlash;
+            light.enable = block->flash;
+            light.position = Vec3ToImVec4(block->position +
+                                          vec3(0.0f, 1.5f, 0.0f));
+            lights.push_back(light.clusterLight());
+        }
+    }
+}
+
+// Point and spot lights for the clustered pass; switched-off ones are
+// left out
+vector<ClusterLight> gatherClusterLights(
+        vector<ClusterLight> const &flashLights) {
+    vector<ClusterLight> lights;
+    for (LightParameters const *light : {&lightPoint, &lightSpot1,
+                                         &lightSpot2}) {
+        if (light->enable > 0.0f) {
+            lights.push_back(light->clusterLight());
+        }
+    }
+    lights.insert(lights.end(), flashLights.begin(), flashLights.end());
+    return lights;
+}
+
+ShaderDefines modelPermutation(bool const reflect, bool const refract,
+                               bool const clustered) {
+    ShaderDefines defines;
+    defines[pbrEnabled ? "LIGHTING_PBR" : "LIGHTING_LBP"] = "1";
+    defines["SHADOWS"] = shadowsEnabled ? "1" : "0";
+    if (Mesh::quantizeVertices) {
+        defines["QUANTIZED_VERTICES"] = "1";
+    }
+    if (reflect) {
+        defines["SURFACE_REFLECT"] = "1";
+    } else if (refract) {
+        defines["SURFACE_REFRACT"] = "1";
+    } else {
+        defines["SURFACE_OPAQUE"] = "1";
+        if (clustered) {
+            defines["CLUSTERED_LIGHTS"] = "1";
+            for (auto const &define : LightClusters::defines()) {
+                defines.insert(define);
+            }
+        }
+    }
+    return defines;
+}
+
 // /////////////////////////////////////////////////// Struct: GraphNode //
 struct GraphNode {
     vector<mat4> transform;
+    vector<mat4> previousTransform;
     vector<shared_ptr<Renderable>> model;
     vector<int> instances;
     vector<vec3> offset;
@@ -462,55 +616,266 @@ struct GraphNode {
     GLuint overrideTexture;
     int iSkybox;
 
-    GraphNode() : overrideTexture(0) {}
+    // Variants of the model shader, picked per object and render call
+    shared_ptr<ShaderPermutations> modelShaders;
+    shared_ptr<LightClusters> lightClusters;
+    shared_ptr<DrawData> drawData;
+
+    // Camera of the previous frame and the sub-pixel jitter of both
+    // frames, from which the main pass writes velocities
+    mat4 previousVp, previousSkyboxVp;
+    vec2 jitter, previousJitter;
+
+    // Levels of detail follow the main camera in every pass: its
+    // projection's vertical scale, and a multiplier of the projected
+    // size at which objects switch
+    float lodProjectionScale, lodDetail;
+
+    // Position of the main camera, which levels of detail and specular
+    // highlights follow in every pass
+    vec3 viewPosition;
+
+    // Culling results of the last render call
+    vector<BoundingBox> bounds;
+    vector<char> visible;
+    int submitted, culled;
+
+    GraphNode() : overrideTexture(0),
+                  previousVp(1.0f), previousSkyboxVp(1.0f),
+                  jitter(0.0f), previousJitter(0.0f),
+                  lodProjectionScale(1.0f), lodDetail(1.0f),
+                  viewPosition(0.0f), submitted(0), culled(0) {}
+
+    // Each level halves the triangles, so one is dropped whenever the
+    // projected radius halves below LOD_FULL_DETAIL_SIZE of the half
+    // screen height; the shadow pass goes one level further
+    int selectLod(int const i, bool const shadow) const {
+        static float const LOD_FULL_DETAIL_SIZE = 0.5f;
+
+        int const lods = model[i]->lodCount();
+        if (i == iSkybox || lods < 2) {
+            return 0;
+        }
+
+        float const radius = 0.5f * glm::distance(bounds[i].min,
+                                                  bounds[i].max);
+        float const distance = glm::distance(bounds[i].center(),
+                                             viewPosition);
+        int lod = 0;
+        if (distance > radius) {
+            float const size = lodDetail * lodProjectionScale * radius /
+                               distance;
+            if (size < LOD_FULL_DETAIL_SIZE) {
+                lod = static_cast<int>(
+                        std::log2(LOD_FULL_DETAIL_SIZE / size));
+            }
+        }
+        return glm::min(lod + (shadow ? 1 : 0), lods - 1);
+    }
+
+    // Drops every object, along with the batches of the last render
+    // call, which share the models
+    void clear() {
+        transform.clear();
+        previousTransform.clear();
+        model.clear();
+        instances.clear();
+        offset.clear();
+        reflect.clear();
+        refract.clear();
+        batches.clear();
+        draws.clear();
+    }
+
+    void cull(mat4 const &vp) {
+        bounds.resize(model.size());
+        for (int i = 0; i < model.size(); i++) {
+            bounds[i] = model[i] ? model[i]->boundingBox.transformed(
+                                           transform[i])
+                                 : BoundingBox::empty();
+        }
+        Frustum(vp).cull(bounds, visible);
+
+        submitted = culled = 0;
+        for (int i = 0; i < model.size(); i++) {
+            if (!model[i]) {
+                continue;
+            }
+            if (visible[i]) {
+                submitted++;
+            } else {
+                culled++;
+            }
+        }
+    }
 
     void render(mat4 const &vp, mat4 const &projection, mat4 const &view,
                 mat4 const &lightSpaceTransform = mat4(1.0),
                 shared_ptr<Shader> const &shadowShader = nullptr) {
-        for (int i = 0; i < model.size(); i++) {
-            mat4 renderTransform = vp * transform[i];
+        cull(vp);
+
+        // At most three variants are needed per call, so look them up
+        // once instead of per object
+        bool const clustered = lightClusters->lightCount() > 0;
+        shared_ptr<Shader> opaqueShader, reflectShader, refractShader;
+        if (!shadowShader) {
+            opaqueShader = modelShaders->get(
+                    modelPermutation(false, false, clustered));
+            reflectShader = modelShaders->get(
+                    modelPermutation(true, false, clustered));
+            refractShader = modelShaders->get(
+                    modelPermutation(false, true, clustered));
+        }
 
-            if (model[i]) {
-                shared_ptr<Shader> shader = shadowShader ? shadowShader
-                                                         : model[i]->shader;
+        // Objects sharing model, level of detail and shader are drawn
+        // as instances of one draw per mesh
+        batches.clear();
+        for (int i = 0; i < model.size(); i++) {
+            if (!model[i] || !visible[i]) {
+                continue;
+            }
+            // The skybox writes no depth, so it has no shadow to cast
+            if (i == iSkybox) {
+                if (!shadowShader) {
+                    renderSkybox(i, projection, view);
+                }
+                continue;
+            }
 
-                shader->use();
+            shared_ptr<Shader> const &shader =
+                    shadowShader ? shadowShader
+                    : reflect[i] ? reflectShader
+                    : refract[i] ? refractShader
+                    : opaqueShader;
+            int const lod = selectLod(i, shadowShader != nullptr);
+
+            auto batch = std::find_if(
+                    batches.begin(), batches.end(),
+                    [&](Batch const &candidate) {
+                        return candidate.model == model[i] &&
+                               candidate.lod == lod &&
+                               candidate.shader == shader;
+                    });
+            if (batch == batches.end()) {
+                batches.push_back({model[i], lod, shader, 0, {}});
+                batch = batches.end() - 1;
+            }
+            batch->objects.push_back(i);
+        }
 
-                if (i == iSkybox) {
-                    glDepthFunc(GL_LEQUAL);
-                    renderTransform =
-                            projection * mat4(mat3(view)) * transform[i];
-                } else {
-                    glDepthFunc(GL_LESS);
+        draws.clear();
+        for (Batch &batch : batches) {
+            batch.firstDraw = static_cast<int>(draws.size());
+            for (int const material : batch.model->materials()) {
+                for (int const i : batch.objects) {
+                    draws.push_back({transform[i], vp * transform[i],
+                                     previousVp * previousTransform[i],
+                                     glm::uvec4(material, 0, 0, 0)});
                 }
+            }
+        }
+        drawData->upload(draws);
+        if (!shadowShader) {
+            Model::materialTable->bind();
+        }
 
-                shader->uniform1i("reflectOverride",
-                                  (int) (reflect[i]));
-                shader->uniform1i("refractOverride",
-                                  (int) (refract[i]));
-
-                shader->uniformMatrix4fv("transform",
-                                         value_ptr(
-                                                 renderTransform));
-                shader->uniformMatrix4fv("world",
-                                         value_ptr(
-                                                 transform[i]));
-                shader->uniformMatrix4fv("lightSpaceTransform",
-                                         value_ptr(lightSpaceTransform));
-                shader->uniform3f("viewPos", cameraPos.x,
-                                  cameraPos.y,
-                                  cameraPos.z);
-                shader->uniform3f("offset", offset[i]);
-
-                lightDirectional.setShaderParameters(shader);
-//                lightPoint.setShaderParameters(shader);
-//                lightSpot1.setShaderParameters(shader);
-//                lightSpot2.setShaderParameters(shader);
-
-                model[i]->render(shader);
+        glDepthFunc(GL_LESS);
+        for (Batch const &batch : batches) {
+            shared_ptr<Shader> const &shader = batch.shader;
+            shader->use();
+            shader->uniformMatrix4fv("lightSpaceTransform",
+                                     value_ptr(lightSpaceTransform));
+            shader->uniform3f("viewPos", viewPosition.x, viewPosition.y,
+                              viewPosition.z);
+            if (!shadowShader) {
+                shader->uniform2f("jitter", jitter.x, jitter.y);
+                shader->uniform2f("previousJitter",
+                                  previousJitter.x, previousJitter.y);
+                lightDirectional.setShaderParameters(shader,
+                                                     lightDirectional.name);
+                if (shader == opaqueShader && clustered) {
+                    lightClusters->setShaderParameters(shader);
+                }
             }
+
+            batch.model->render(shader, batch.lod,
+                                static_cast<int>(batch.objects.size()),
+                                batch.firstDraw);
         }
     }
+
+private:
+    struct Batch {
+        shared_ptr<Renderable> model;
+        int lod;
+        shared_ptr<Shader> shader;
+        int firstDraw;
+        vector<int> objects;
+    };
+
+    void renderSkybox(int const i, mat4 const &projection,
+                      mat4 const &view) {
+        shared_ptr<Shader> const &shader = model[i]->shader;
+        shader->use();
+
+        glDepthFunc(GL_LEQUAL);
+        mat4 const renderTransform =
+                projection * mat4(mat3(view)) * transform[i];
+        mat4 const previousRenderTransform =
+                previousSkyboxVp * previousTransform[i];
+        shader->uniformMatrix4fv("transform", value_ptr(renderTransform));
+        shader->uniformMatrix4fv("previousTransform",
+                                 value_ptr(previousRenderTransform));
+        shader->uniform2f("jitter", jitter.x, jitter.y);
+        shader->uniform2f("previousJitter",
+                          previousJitter.x, previousJitter.y);
+
+        model[i]->render(shader);
+    }
+
+    // Rebuilt by every render call, kept for their storage
+    vector<Batch> batches;
+    vector<DrawParameters> draws;
+};
+
+// /////////////////////////////////////////////// Struct: FrameSnapshot //
+// Everything the renderer takes from one step of the simulation. The
+// simulation copies it out and goes on with the next step while the
+// render thread draws this one, so nothing in here points back into the
+// game's state. Snapshots are reused, their vectors keep their storage.
+struct FrameSnapshot {
+    // Objects to draw, laid out as in GraphNode; destroyed blocks are
+    // left out
+    vector<mat4> transform;
+    vector<mat4> previousTransform;
+    vector<shared_ptr<Renderable>> model;
+    vector<bool> reflect;
+    vector<bool> refract;
+
+    // Lights of blocks that were just hit
+    vector<ClusterLight> flashLights;
+
+    vec3 cameraPos{0.0f}, cameraFront{1.0f, 0.0f, 0.0f};
+    int displayWidth = 0, displayHeight = 0;
+
+    // Heads-up display
+    bool menu = true;
+    int points = 0, lives = 0;
+    bool showUserInterface = false;
+
+    // F2 was pressed; the trace is written by the profiler's thread
+    bool exportTrace = false;
+
+    // Dear ImGui's platform input as of this step. The main thread may
+    // run the backend for the next step before this step's UI frame is
+    // built, so the UI frame puts these back first; a click shorter than
+    // a step is latched in mouseDown rather than overwritten
+    ImVec2 displaySize{0.0f, 0.0f}, framebufferScale{1.0f, 1.0f};
+    ImVec2 mousePosition{-FLT_MAX, -FLT_MAX};
+    bool mouseDown[sizeof(ImGuiIO::MouseDown) / sizeof(bool)] = {};
+    float interfaceDeltaTime = 1.0f / 60.0f;
+
+    Profiler::clock::time_point simulationStart, simulationEnd;
 };
 
 // /////////////////////////////////////////////////////////// Constants //
@@ -522,9 +887,23 @@ char const *WINDOW_TITLE = "Tomasz Witczak 216920 - Zadanie 5";
 // ----------------------------------------------------------- Window -- //
 GLFWwindow *window = nullptr;
 
+// ------------------------------------------------- Headless backend -- //
+bool headlessMode = false;
+shared_ptr<HeadlessContext> headless;
+string frameDumpDirectory;
+int frameLimit = 0;
+
 // ---------------------------------------------------------- Shaders -- //
 shared_ptr<Shader> textShader, skyboxShader,
         modelShader, lightbulbShader, shadowShader;
+shared_ptr<ShaderPermutations> modelShaders;
+shared_ptr<LightClusters> lightClusters;
+
+// Ring for data rewritten every frame
+shared_ptr<StreamBuffer> streamBuffer;
+
+// Recompiles shaders edited while the game runs
+shared_ptr<FileWatcher> shaderWatcher;
 
 // ----------------------------------------------------------- Camera -- //
 vec3 cameraFront(1.0f, 0.0f, 0.0f),
@@ -548,14 +927,65 @@ GLfloat mouseSensitivityFactor = 0.01f;
 // ------------------------------------------------------ Scene graph -- //
 GraphNode scene;
 
+int shadowPassCulled = 0, mainPassCulled = 0;
+
 // --------------------------------------------------- Rendering mode -- //
 bool wireframeMode = false;
 bool showLightDummies = true;
+bool showUserInterface = false;
+
+// The scene is drawn at this fraction of the window's resolution
+float renderScale = 1.0f;
+Antialiasing antialiasing = AA_MSAA;
+shared_ptr<PostProcessing> postProcessing;
+
+// Adjusts the render scale to the GPU frame time; a zero budget is
+// derived from the monitor's refresh rate
+bool dynamicResolutionMode = false;
+DynamicResolutionSettings dynamicResolutionSettings = {0.5f, 1.0f, 0.0f};
+shared_ptr<DynamicResolution> dynamicResolution;
+
+// -------------------------------------------------------- Profiling -- //
+shared_ptr<Profiler> profiler;
+char const *TRACE_FILENAME = "frame-trace.json";
+
+// Set by F2 and passed on with the next snapshot
+bool exportTraceRequested = false;
+
+// ---------------------------------------------------------- Threads -- //
+// Windowed play simulates on the main thread and renders on a thread of
+// its own, one step ahead; the other modes run both on one thread
+bool renderThreadMode = true;
+TripleBuffer<FrameSnapshot> snapshots;
+
+// The threads take turns over every snapshot. Snapshots themselves pass
+// without locks, the mutex only guards sleeping on the condition
+mutex pacingMutex;
+condition_variable pacing;
+atomic<bool> stopRendering(false);
+exception_ptr renderError;
+
+// Dear ImGui gets its input from GLFW on the main thread and builds its
+// frames on the render thread
+mutex interfaceMutex;
+
+// -------------------------------------------------------- Benchmark -- //
+bool benchmarkMode = false;
+BenchmarkSettings benchmarkSettings = {20.0f, 1280, 720, "benchmark.csv"};
+shared_ptr<Benchmark> benchmark;
+
+// ------------------------------------------------------- Regression -- //
+bool regressionMode = false;
+RegressionSettings regressionSettings = {960, 540, "res/regression",
+                                         "regression.csv", false,
+                                         5.0f, 0.005f};
+shared_ptr<Regression> regression;
 
 // ----------------------------------------------------------- Models -- //
 shared_ptr<Renderable> skybox, ground, teapot, weird, lightbulb, spotbulb;
 
 shared_ptr<ShadowMap> shadowMap;
+shared_ptr<EnvironmentLighting> environment;
 
 // ------------------------------------------------------------- Game -- //
 vector<shared_ptr<Block>> blocks;
@@ -563,121 +993,61 @@ shared_ptr<Palette> palette;
 shared_ptr<Ball> ball;
 
 // //////////////////////////////////////////////////////////// Textures //
-GLuint loadTextureFromFile(string const &filename) {
-    // Generate OpenGL resource
-    GLuint texture;
-    glGenTextures(1, &texture);
-
-    // Setup the texture
-    glBindTexture(GL_TEXTURE_2D, texture);
-    {
-        // Set texture parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        // Load texture from file
-        stbi_set_flip_vertically_on_load(true);
-
-        int imageWidth, imageHeight, imageNumberOfChannels;
-        unsigned char *textureData = stbi_load(
-                filename.c_str(),
-                &imageWidth, &imageHeight,
-                &imageNumberOfChannels, 0);
-
-        if (textureData == nullptr) {
-            throw exception("Failed to load texture!");
+gl::Texture loadCubemapFromFile(vector<string> const &filenames) {
+    // Load every face first, the storage is allocated for their size
+    struct Face {
+        int width, height, numberOfChannels;
+        unique_ptr<unsigned char, void (*)(void *)> data;
+    };
+
+    stbi_set_flip_vertically_on_load(false);
+
+    vector<Face> faces;
+    for (auto const &filename : filenames) {
+        Face face{0, 0, 0, {nullptr, stbi_image_free}};
+        face.data.reset(stbi_load(filename.c_str(),
+                                  &face.width, &face.height,
+                                  &face.numberOfChannels, 0));
+        if (face.data == nullptr) {
+            throw runtime_error("Failed to load texture!");
         }
+        faces.push_back(std::move(face));
+    }
 
-        // Pass image to OpenGL
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB,
-                     imageWidth, imageHeight, 0,
-                     [&]() -> GLenum {
-                         switch (imageNumberOfChannels) {
-                             case 1:
-                                 return GL_RED;
-                             case 3:
-                                 return GL_RGB;
-                             case 4:
-                                 return GL_RGBA;
-                             default:
-                                 return GL_RGB;
-                         }
-                     }(),
-                     GL_UNSIGNED_BYTE, textureData);
-
-        // Generate mipmap for loaded texture
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        // After loading into OpenGL - release the raw resource
-        stbi_image_free(textureData);
-    }
-
-    // Return texture's ID
-    return texture;
-}
-
-GLuint loadCubemapFromFile(vector<string> const &filenames) {
-    // Generate OpenGL resource
-    GLuint texture;
-    glGenTextures(1, &texture);
-
-    // Setup the texture
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
-    {
-        // Set texture parameters
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
-                        GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER,
-                        GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S,
-                        GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T,
-                        GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R,
-                        GL_CLAMP_TO_EDGE);
-
-        // Load texture from file
-        stbi_set_flip_vertically_on_load(false);
-
-        for (int i = 0; i < filenames.size(); ++i) {
-            int imageWidth, imageHeight, imageNumberOfChannels;
-            unsigned char *textureData = stbi_load(
-                    filenames[i].c_str(),
-                    &imageWidth, &imageHeight,
-                    &imageNumberOfChannels, 0);
-
-            if (textureData == nullptr) {
-                throw exception("Failed to load texture!");
-            }
-
-            // Pass image to OpenGL
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB,
-                         imageWidth, imageHeight, 0,
-                         [&]() -> GLenum {
-                             switch (imageNumberOfChannels) {
-                                 case 1:
-                                     return GL_RED;
-                                 case 3:
-                                     return GL_RGB;
-                                 case 4:
-                                     return GL_RGBA;
-                                 default:
-                                     return GL_RGB;
-                             }
-                         }(),
-                         GL_UNSIGNED_BYTE, textureData);
-
-            // Generate mipmap for loaded texture
-            glGenerateMipmap(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
-
-            // After loading into OpenGL - release the raw resource
-            stbi_image_free(textureData);
-        }
+    // Room for a full mip chain, EnvironmentLighting generates it. The
+    // images are sRGB; decoding them in the sampler keeps both the mips
+    // and their filtering in linear space
+    int const size = faces.front().width;
+    gl::Texture texture(GL_TEXTURE_CUBE_MAP,
+                        gl::Texture::levelCount(size, size),
+                        GL_SRGB8_ALPHA8, size, size);
+
+    // Set texture parameters
+    texture.parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    texture.parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    texture.parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    texture.parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    texture.parameter(GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    // Pass faces to OpenGL, in the order of the cube map's layers
+    for (int i = 0; i < faces.size(); ++i) {
+        Face const &face = faces[i];
+        texture.upload(0, 0, 0, i, face.width, face.height, 1,
+                       [&]() -> GLenum {
+                           switch (face.numberOfChannels) {
+                               case 1:
+                                   return GL_RED;
+                               case 3:
+                                   return GL_RGB;
+                               case 4:
+                                   return GL_RGBA;
+                               default:
+                                   return GL_RGB;
+                           }
+                       }(),
+                       GL_UNSIGNED_BYTE, face.data.get());
     }
 
-    // Return texture's ID
     return texture;
 }
 
@@ -690,11 +1060,17 @@ void setupDearImGui() {
 
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init(GLSL_VERSION);
+    ImGui_ImplOpenGL3_SetStreamBuffer(streamBuffer.get());
 
     ImGui::StyleColorsLight();
 
     ImGui::GetIO().Fonts->AddFontFromFileTTF("res/fonts/montserrat.ttf",
                                              12.0f, nullptr);
+
+    // The platform side of a frame may start on the main thread before
+    // the render thread ever gets to ImGui_ImplOpenGL3_NewFrame, so the
+    // font atlas has to be built up front
+    ImGui_ImplOpenGL3_CreateDeviceObjects();
 }
 
 void constructTabForLight(LightParameters &light) {
@@ -751,9 +1127,136 @@ void constructTabForLight(LightParameters &light) {
     ImGui::EndTabItem();
 }
 
+void constructProfilerSection() {
+    ImGui::Text("Culled objects | shadow: %d | main: %d",
+                shadowPassCulled, mainPassCulled);
+    ImGui::NewLine();
+
+    ImGui::Columns(5, "Profiler");
+    ImGui::Text("Scope [ms]");
+    ImGui::NextColumn();
+    ImGui::Text("CPU avg");
+    ImGui::NextColumn();
+    ImGui::Text("CPU p95/p99");
+    ImGui::NextColumn();
+    ImGui::Text("GPU avg");
+    ImGui::NextColumn();
+    ImGui::Text("GPU p95/p99");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    for (auto const &name : profiler->scopeNames()) {
+        Profiler::Statistics const cpu = profiler->cpuStatistics(name);
+        Profiler::Statistics const gpu = profiler->gpuStatistics(name);
+
+        ImGui::Text("%s", name.c_str());
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", cpu.average);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f / %.3f", cpu.p95, cpu.p99);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", gpu.average);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f / %.3f", gpu.p95, gpu.p99);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+    ImGui::NewLine();
+
+    if (ImGui::Button("Export Chrome trace")) {
+        profiler->exportChromeTrace(TRACE_FILENAME);
+    }
+}
+
+void constructFrameStatsSection() {
+    FrameStats const &frame = stats::lastFrame();
+
+    ImGui::Columns(7, "Frame statistics");
+    for (char const *header : {"Pass", "Draws", "Triangles", "Uniforms",
+                               "Textures", "Programs", "Uploads"}) {
+        ImGui::Text("%s", header);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+
+    auto const row = [](string const &name, PassStats const &pass) {
+        ImGui::Text("%s", name.c_str());
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) pass.drawCalls);
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) pass.triangles);
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) pass.uniformUploads);
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) pass.textureBinds);
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) pass.programSwitches);
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) pass.bufferUploads);
+        ImGui::NextColumn();
+    };
+    for (auto const &pass : frame.passes) {
+        row(pass.first, pass.second);
+    }
+    ImGui::Separator();
+    row("Total", frame.total);
+    ImGui::Columns(1);
+}
+
+void constructGpuMemorySection() {
+    ImGui::Columns(3, "GPU memory");
+    for (char const *header : {"Category", "Objects", "MiB"}) {
+        ImGui::Text("%s", header);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+
+    auto const row = [](char const *name, resources::Usage const &usage) {
+        ImGui::Text("%s", name);
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) usage.objects);
+        ImGui::NextColumn();
+        ImGui::Text("%.2f", usage.bytes / (1024.0f * 1024.0f));
+        ImGui::NextColumn();
+    };
+    for (int category = 0; category < resources::CATEGORY_COUNT;
+         ++category) {
+        auto const current = static_cast<resources::Category>(category);
+        row(resources::categoryName(current), resources::usage(current));
+    }
+    ImGui::Separator();
+    row("Total", resources::total());
+    row("Awaiting deletion", resources::pending());
+    ImGui::Columns(1);
+}
+
+// Takes the platform input ImGui_ImplGlfw_NewFrame left in Dear ImGui's
+// IO; main thread, under interfaceMutex
+void captureInterfaceInput(FrameSnapshot &snapshot) {
+    ImGuiIO const &io = ImGui::GetIO();
+    snapshot.displaySize = io.DisplaySize;
+    snapshot.framebufferScale = io.DisplayFramebufferScale;
+    snapshot.mousePosition = io.MousePos;
+    copy(begin(io.MouseDown), end(io.MouseDown), snapshot.mouseDown);
+    snapshot.interfaceDeltaTime = io.DeltaTime;
+}
+
+// Puts the snapshot's platform input back before its UI frame is built;
+// render thread, under interfaceMutex
+void restoreInterfaceInput(FrameSnapshot const &snapshot) {
+    ImGuiIO &io = ImGui::GetIO();
+    io.DisplaySize = snapshot.displaySize;
+    io.DisplayFramebufferScale = snapshot.framebufferScale;
+    io.MousePos = snapshot.mousePosition;
+    copy(begin(snapshot.mouseDown), end(snapshot.mouseDown),
+         io.MouseDown);
+    io.DeltaTime = snapshot.interfaceDeltaTime;
+}
+
+// The platform input of the frame comes from the snapshot, see
+// restoreInterfaceInput
 void prepareUserInterfaceWindow() {
     ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
     ImGui::Begin("Task 4", nullptr,
                  ImGuiWindowFlags_NoDecoration |
@@ -767,12 +1270,43 @@ void prepareUserInterfaceWindow() {
         if (ImGui::Button("Toggle PBR/LBP lighting")) {
             pbrEnabled = !pbrEnabled;
         }
+        if (ImGui::Button("Toggle shadows")) {
+            shadowsEnabled = !shadowsEnabled;
+        }
         if (ImGui::Button("Toggle light dummies")) {
             showLightDummies = !showLightDummies;
         }
         if (ImGui::Button("Toggle wireframe mode")) {
             wireframeMode = !wireframeMode;
         }
+        if (ImGui::Button("Toggle bloom")) {
+            postProcessing->bloom = !postProcessing->bloom;
+        }
+        if (ImGui::Button("Toggle dynamic resolution")) {
+            if (dynamicResolution) {
+                dynamicResolution = nullptr;
+            } else {
+                dynamicResolution = make_shared<DynamicResolution>(
+                        dynamicResolutionSettings);
+            }
+        }
+        if (dynamicResolution) {
+            ImGui::Text("Render scale %.2f (GPU %.2f / %.2f ms)",
+                        dynamicResolution->scale(),
+                        dynamicResolution->averageTime(),
+                        dynamicResolutionSettings.budget);
+        } else {
+            ImGui::SliderFloat("Render scale", &renderScale, 0.25f, 2.0f);
+        }
+        ImGui::SliderFloat("Exposure", &postProcessing->exposure,
+                           0.1f, 4.0f);
+        ImGui::SliderFloat("LOD detail", &scene.lodDetail, 0.25f, 4.0f);
+        int antialiasingMode = postProcessing->antialiasing;
+        if (ImGui::Combo("Anti-aliasing", &antialiasingMode,
+                         "Off\0MSAA\0TAA\0")) {
+            postProcessing->antialiasing =
+                    static_cast<Antialiasing>(antialiasingMode);
+        }
         ImGui::NewLine();
         ImGui::Separator();
 
@@ -793,6 +1327,19 @@ void prepareUserInterfaceWindow() {
 
         ImGui::EndTabBar();
 
+        ImGui::NewLine();
+        ImGui::Separator();
+        if (ImGui::CollapsingHeader("Profiler",
+                                    ImGuiTreeNodeFlags_DefaultOpen)) {
+            constructProfilerSection();
+        }
+        if (ImGui::CollapsingHeader("Frame statistics")) {
+            constructFrameStatsSection();
+        }
+        if (ImGui::CollapsingHeader("GPU memory")) {
+            constructGpuMemorySection();
+        }
+
         ImGui::SetWindowPos(ImVec2(0.0f, 0.0f));
     }
     ImGui::End();
@@ -811,27 +1358,45 @@ void setupGLFW() {
                      << description;
             });
     if (!glfwInit()) {
-        throw exception("glfwInit error");
+        throw runtime_error("glfwInit error");
     }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
     glfwWindowHint(GLFW_OPENGL_PROFILE,
                    GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-    glfwWindowHint(GLFW_SAMPLES, 4);
+    // Multisampling happens in the HDR scene target
+    glfwWindowHint(GLFW_SAMPLES, 0);
+
+    // Benchmark runs at a fixed resolution
+    if (benchmarkMode) {
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    }
 }
 
 void createWindow() {
-    window = glfwCreateWindow(WINDOW_WIDTH,
-                              WINDOW_HEIGHT,
+    window = glfwCreateWindow(benchmarkMode ? benchmarkSettings.width
+                                            : WINDOW_WIDTH,
+                              benchmarkMode ? benchmarkSettings.height
+                                            : WINDOW_HEIGHT,
                               WINDOW_TITLE,
                               nullptr,
                               nullptr);
     if (window == nullptr) {
-        throw exception("glfwCreateWindow error");
+        throw runtime_error("glfwCreateWindow error");
     }
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);  // Enable vertical synchronization
+    // Enable vertical synchronization, unless measuring frame times
+    glfwSwapInterval(benchmarkMode ? 0 : 1);
+}
+
+float refreshInterval() {
+    GLFWvidmode const *mode = headless
+                              ? nullptr
+                              : glfwGetVideoMode(glfwGetPrimaryMonitor());
+    int const refreshRate = mode != nullptr && mode->refreshRate > 0
+                            ? mode->refreshRate : 60;
+    return 1000.0f / refreshRate;
 }
 
 void initializeOpenGLLoader() {
@@ -845,13 +1410,13 @@ void initializeOpenGLLoader() {
             (GLADloadproc) glfwGetProcAddress);
 #endif
     if (failedToInitializeOpenGL) {
-        throw exception(
+        throw runtime_error(
                 "Failed to initialize OpenGL loader!");
     }
 }
 
-void setupSceneGraph(float const deltaTime, float const displayWidth,
-                     float const displayHeight) {
+// Objects of the scene as the game has them now
+void captureScene(FrameSnapshot &snapshot) {
     static mat4 const identity = mat4(1.0f);
 //    static float angle = 0.0f;
 //    angle += glm::radians(30.0f) * deltaTime;
@@ -861,108 +1426,93 @@ void setupSceneGraph(float const deltaTime, float const displayWidth,
 //            glm::rotate(identity, angle, vec3(0.0f, 1.0f, 0.0f)) *
 //            glm::vec4(25, 5, 0, 1));
 
-    // Scene elements
-    scene.transform.clear();
-    scene.model.clear();
-    scene.instances.clear();
-    scene.offset.clear();
-    scene.reflect.clear();
-    scene.refract.clear();
-
-    scene.iSkybox = 0;
-    scene.transform.push_back(identity);
-    scene.model.push_back(skybox);
-    scene.instances.push_back(1);
-    scene.offset.emplace_back(0);
-    scene.reflect.emplace_back(false);
-    scene.refract.emplace_back(false);
-
-    scene.transform.push_back(identity);
-    scene.model.push_back(ground);
-    scene.instances.push_back(1);
-    scene.offset.emplace_back(0);
-    scene.reflect.emplace_back(false);
-    scene.refract.emplace_back(false);
-
-//    scene.transform.push_back(identity);
-//    scene.model.push_back(weird);
-//    scene.instances.push_back(25);
-//    scene.offset.emplace_back(2.5, 0, 2.5);
-//    scene.reflect.emplace_back(true);
-//    scene.refract.emplace_back(false);
-//
-    scene.transform.push_back(identity);
-    scene.model.push_back(teapot);
-    scene.instances.push_back(1);
-    scene.offset.emplace_back(0);
-    scene.reflect.emplace_back(false);
-    scene.refract.emplace_back(true);
+    snapshot.transform.clear();
+    snapshot.previousTransform.clear();
+    snapshot.model.clear();
+    snapshot.reflect.clear();
+    snapshot.refract.clear();
+
+    auto const add = [&](mat4 const &transform,
+                         mat4 const &previousTransform,
+                         shared_ptr<Renderable> const &model,
+                         bool const reflect, bool const refract) {
+        snapshot.transform.push_back(transform);
+        snapshot.previousTransform.push_back(previousTransform);
+        snapshot.model.push_back(model);
+        snapshot.reflect.push_back(reflect);
+        snapshot.refract.push_back(refract);
+    };
+
+    // Scene elements; the skybox comes first, see setupSceneGraph
+    add(identity, identity, skybox, false, false);
+    add(identity, identity, ground, false, false);
+//    add(identity, identity, weird, true, false);
+    add(identity, identity, teapot, false, true);
 
     for (auto const &block : blocks) {
-        if (!block->render) {
-            continue;
+        if (block->render) {
+            add(block->transform, block->transform, block->model,
+                false, false);
         }
-        scene.transform.push_back(block->transform);
-        scene.model.push_back(block->model);
-        scene.instances.push_back(1);
-        scene.offset.emplace_back(0);
-        scene.reflect.emplace_back(false);
-        scene.refract.emplace_back(false);
-    }
-
-    scene.transform.push_back(glm::translate(identity, palette->position));
-    scene.model.push_back(palette->model);
-    scene.instances.push_back(1);
-    scene.offset.emplace_back(0);
-    scene.reflect.emplace_back(false);
-    scene.refract.emplace_back(false);
-
-    scene.transform.push_back(glm::translate(identity, ball->position));
-    scene.model.push_back(ball->model);
-    scene.instances.push_back(1);
-    scene.offset.emplace_back(0);
-    scene.reflect.emplace_back(true);
-    scene.refract.emplace_back(false);
+    }
+
+    add(glm::translate(identity, palette->position),
+        glm::translate(identity, palette->previousPosition),
+        palette->model, false, false);
+    add(glm::translate(identity, ball->position),
+        glm::translate(identity, ball->previousPosition),
+        ball->model, true, false);
+
+    // Moving objects remember where they were for the next frame's
+    // velocities
+    palette->previousPosition = palette->position;
+    ball->previousPosition = ball->position;
 
 //    if (showLightDummies) {
-//        scene.transform.push_back(glm::translate(mat4(1), ImVec4ToVec3(
+//        snapshot.transform.push_back(glm::translate(mat4(1), ImVec4ToVec3(
 //                lightPoint.position)));
-//        scene.model.push_back(lightbulb);
-//        scene.instances.push_back(1);
-//        scene.offset.emplace_back(0);
-//        scene.reflect.emplace_back(false);
-//        scene.refract.emplace_back(false);
+//        snapshot.model.push_back(lightbulb);
+//        snapshot.reflect.emplace_back(false);
+//        snapshot.refract.emplace_back(false);
 //
 //        vec3 a = glm::normalize(vec3(0, -1, 0));
 //        vec3 b = glm::normalize(ImVec4ToVec3(lightSpot1.direction));
-//        scene.transform.push_back(
+//        snapshot.transform.push_back(
 //                glm::translate(mat4(1),
 //                               ImVec4ToVec3(lightSpot1.position)) *
 //                glm::toMat4(glm::angleAxis(glm::acos(glm::dot(a, b)),
 //                                           glm::normalize(
 //                                                   glm::cross(a, b)))));
-//        scene.model.push_back(spotbulb);
-//        scene.instances.push_back(1);
-//        scene.offset.emplace_back(0);
-//        scene.reflect.emplace_back(false);
-//        scene.refract.emplace_back(false);
+//        snapshot.model.push_back(spotbulb);
+//        snapshot.reflect.emplace_back(false);
+//        snapshot.refract.emplace_back(false);
 //
 //        a = glm::normalize(vec3(0, -1, 0));
 //        b = glm::normalize(ImVec4ToVec3(lightSpot2.direction));
-//        scene.transform.push_back(
+//        snapshot.transform.push_back(
 //                glm::translate(mat4(1),
 //                               ImVec4ToVec3(lightSpot2.position)) *
 //                glm::toMat4(glm::angleAxis(glm::acos(glm::dot(a, b)),
 //                                           glm::normalize(
 //                                                   glm::cross(a, b)))));
-//        scene.model.push_back(spotbulb);
-//        scene.instances.push_back(1);
-//        scene.offset.emplace_back(0);
-//        scene.reflect.emplace_back(false);
-//        scene.refract.emplace_back(false);
+//        snapshot.model.push_back(spotbulb);
+//        snapshot.reflect.emplace_back(false);
+//        snapshot.refract.emplace_back(false);
 //    }
 }
 
+// Takes the objects of the snapshot into the scene graph
+void setupSceneGraph(FrameSnapshot const &snapshot) {
+    scene.iSkybox = 0;
+    scene.transform = snapshot.transform;
+    scene.previousTransform = snapshot.previousTransform;
+    scene.model = snapshot.model;
+    scene.reflect = snapshot.reflect;
+    scene.refract = snapshot.refract;
+    scene.instances.assign(scene.model.size(), 1);
+    scene.offset.assign(scene.model.size(), vec3(0.0f));
+}
+
 void mouseCallback(GLFWwindow *window, double x, double y) {
     if (menu) {
         return;
@@ -1019,6 +1569,16 @@ void handleKeyboardInput(float const deltaTime) {
         quitProgram = true;
     }
 
+    static bool f1Pressed = false, f2Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS && !f1Pressed) {
+        showUserInterface = !showUserInterface;
+    }
+    f1Pressed = glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS;
+    if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS && !f2Pressed) {
+        exportTraceRequested = true;
+    }
+    f2Pressed = glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS;
+
     //--------------------------------------------------------------
     if (menu) {
         if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS) {
@@ -1086,23 +1646,143 @@ void handleKeyboardInput(float const deltaTime) {
 
 }
 
-void setupOpenGL() {
-    setupGLFW();
-    createWindow();
-    initializeOpenGLLoader();
+void reloadChangedShaders() {
+    vector<shared_ptr<Shader>> shaders = {
+            skyboxShader, textShader, shadowShader, lightClusters->shader()};
+    for (auto const &shader : modelShaders->compiled()) {
+        shaders.push_back(shader);
+    }
+    for (auto const &shader : postProcessing->shaders()) {
+        shaders.push_back(shader);
+    }
 
-    glEnable(GL_MULTISAMPLE);
+    for (string const &file : shaderWatcher->changes()) {
+        for (auto const &shader : shaders) {
+            if (shader->uses(file)) {
+                shader->reload();
+            }
+        }
+    }
+    for (auto const &shader : shaders) {
+        shader->update();
+    }
+}
 
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwSetCursorPosCallback(window, mouseCallback);
+void runBenchmarkScript() {
+    // Keep the game running: no menu, ball always in play, and the
+    // palette tracking the ball with a varying offset
+    menu = false;
+    ball->start();
+    palette->positionTarget.x = ball->position.x +
+                                benchmark->paletteOffset(
+                                        palette->dimensions.x / 2.0f);
+}
 
-    skybox = make_shared<Skybox>();
-    ground = make_shared<Model>("res/models/scene.obj");
-    teapot = make_shared<Model>("res/models/star.obj");
-//    weird = make_shared<Model>("res/models/weird.obj");
-//    lightbulb = make_shared<Model>("res/models/light.obj");
-//    spotbulb = make_shared<Model>("res/models/spot.obj");
+vector<RegressionScene> regressionScenes() {
+    auto const setCamera = [](vec3 const &position, vec3 const &front) {
+        cameraPos = cameraPosTarget = position;
+        cameraFront = cameraFrontTarget = normalize(front);
+    };
 
+    // Every third block destroyed, small palette, ball in flight
+    auto const setGame = []() {
+        resetGame(true);
+        menu = false;
+        wireframeMode = false;
+        for (int i = 0; i < blocks.size(); ++i) {
+            blocks[i]->render = i % 3 != 0;
+            points += i % 3 == 0;
+        }
+        palette->setSmall();
+        palette->position = palette->positionTarget =
+                vec3(-6.0f, 0.0f, -25.0f);
+        ball->sticky = false;
+        ball->position = vec3(4.0f, 0.0f, -5.0f);
+    };
+    vec3 const gameFront = vec3(cos(yaw) * cos(pitch),
+                                sin(pitch),
+                                sin(yaw) * cos(pitch));
+    vec3 const ballView = vec3(3.0f, 2.5f, -4.0f);
+
+    return {
+            {"menu",            [=]() {
+                resetGame(true);
+                wireframeMode = false;
+                setCamera(vec3(0.0f, 50.0f, -30.0f),
+                          vec3(1.0f, 0.0f, 0.0f));
+            }},
+            {"mid-game",        [=]() {
+                setGame();
+                setCamera(vec3(0.0f, 50.0f, -30.0f), gameFront);
+            }},
+            {"wireframe",       [=]() {
+                setGame();
+                wireframeMode = true;
+                setCamera(vec3(0.0f, 50.0f, -30.0f), gameFront);
+            }},
+            {"reflective-ball", [=]() {
+                setGame();
+                setCamera(ball->position + ballView, -ballView);
+            }}
+    };
+}
+
+GLuint defaultFramebuffer() {
+    return headless ? headless->framebuffer() : 0;
+}
+
+void getFramebufferSize(int &width, int &height) {
+    if (headless) {
+        width = headless->width;
+        height = headless->height;
+    } else {
+        glfwGetFramebufferSize(window, &width, &height);
+    }
+}
+
+void setupHeadless() {
+    if (!benchmarkMode && !regressionMode && frameLimit == 0) {
+        throw runtime_error("Headless mode needs --benchmark, "
+                            "--regression or --frames");
+    }
+    if (benchmarkMode && regressionMode) {
+        throw runtime_error("--benchmark and --regression can't be "
+                            "combined");
+    }
+
+    int width = WINDOW_WIDTH, height = WINDOW_HEIGHT;
+    if (benchmarkMode) {
+        width = benchmarkSettings.width;
+        height = benchmarkSettings.height;
+    } else if (regressionMode) {
+        width = regressionSettings.width;
+        height = regressionSettings.height;
+    }
+
+    headless = make_shared<HeadlessContext>(width, height, 0);
+
+    // Frames are written into it from the first one on
+    if (!frameDumpDirectory.empty()) {
+        std::filesystem::create_directories(frameDumpDirectory);
+    }
+}
+
+void setupOpenGL() {
+    if (headlessMode) {
+        setupHeadless();
+    } else {
+        setupGLFW();
+        createWindow();
+        initializeOpenGLLoader();
+
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSetCursorPosCallback(window, mouseCallback);
+    }
+
+    glEnable(GL_MULTISAMPLE);
+
+    // Shaders first, so that the driver compiles them while textures
+    // and models load
     skyboxShader = make_shared<Shader>("res/shaders/skybox/vertex.glsl",
                                        "res/shaders/skybox/geometry.glsl",
                                        "res/shaders/skybox/fragment.glsl");
@@ -1111,20 +1791,53 @@ void setupOpenGL() {
                                      "res/shaders/text/geometry.glsl",
                                      "res/shaders/text/fragment.glsl");
 
-    modelShader = make_shared<Shader>("res/shaders/model/vertex.glsl",
-                                      "res/shaders/model/geometry.glsl",
-                                      "res/shaders/model/fragment.glsl");
-
+    modelShaders = make_shared<ShaderPermutations>(
+            "res/shaders/model/vertex.glsl",
+            "res/shaders/model/geometry.glsl",
+            "res/shaders/model/fragment.glsl");
+    modelShader = modelShaders->get(modelPermutation(false, false, false));
+    scene.modelShaders = modelShaders;
+
+    // The rest of the variants gameplay reaches: the clustered one once
+    // the first light comes on, and the two surfaces with their own
+    // lighting. Requested here, none of them compiles mid-game
+    modelShaders->get(modelPermutation(false, false, true));
+    modelShaders->get(modelPermutation(true, false, false));
+    modelShaders->get(modelPermutation(false, true, false));
+
+    streamBuffer = make_shared<StreamBuffer>();
+    lightClusters = make_shared<LightClusters>(streamBuffer);
+    scene.lightClusters = lightClusters;
+    scene.drawData = make_shared<DrawData>(streamBuffer);
+
+    ShaderDefines shadowDefines;
+    if (Mesh::quantizeVertices) {
+        shadowDefines["QUANTIZED_VERTICES"] = "1";
+    }
     shadowShader = make_shared<Shader>("res/shaders/depth/vertex.glsl",
                                        "res/shaders/depth/geometry.glsl",
-                                       "res/shaders/depth/fragment.glsl");
+                                       "res/shaders/depth/fragment.glsl",
+                                       shadowDefines);
 
 //    lightbulbShader = make_shared<Shader>(
 //            "res/shaders/lightbulb/vertex.glsl",
 //            "res/shaders/lightbulb/geometry.glsl",
 //            "res/shaders/lightbulb/fragment.glsl");
 
+    auto const sky = make_shared<Skybox>();
+    skybox = sky;
+    environment = make_shared<EnvironmentLighting>(sky->cubemap.id(),
+                                                   sky->filenames);
+    Model::materialTable = make_shared<MaterialTable>();
+    ground = make_shared<Model>("res/models/scene.obj");
+    teapot = make_shared<Model>("res/models/star.obj");
+//    weird = make_shared<Model>("res/models/weird.obj");
+//    lightbulb = make_shared<Model>("res/models/light.obj");
+//    spotbulb = make_shared<Model>("res/models/spot.obj");
+
     shadowMap = make_shared<ShadowMap>(2048, 2048);
+    postProcessing = make_shared<PostProcessing>(4);
+    postProcessing->antialiasing = antialiasing;
 
     skybox->shader = skyboxShader;
     ground->shader = modelShader;
@@ -1133,44 +1846,106 @@ void setupOpenGL() {
 //    lightbulb->shader = lightbulbShader;
 //    spotbulb->shader = lightbulbShader;
 
-    font = make_shared<Font>("res/fonts/changaone.ttf", 72, textShader);
+    font = make_shared<Font>("res/fonts/changaone.ttf", 72, textShader,
+                             streamBuffer);
 
-    setupDearImGui();
+    profiler = make_shared<Profiler>();
+    if (dynamicResolutionSettings.budget <= 0.0f) {
+        dynamicResolutionSettings.budget = refreshInterval();
+    }
+    // Reference images need a fixed resolution
+    if (dynamicResolutionMode && !regressionMode) {
+        dynamicResolution = make_shared<DynamicResolution>(
+                dynamicResolutionSettings);
+    }
+    if (benchmarkMode) {
+        benchmark = make_shared<Benchmark>(benchmarkSettings);
+    }
+    if (regressionMode) {
+        regression = make_shared<Regression>(regressionSettings,
+                                             regressionScenes());
+    }
+
+    if (!headless) {
+        setupDearImGui();
+    }
+    if (!headless && !benchmarkMode) {
+        shaderWatcher = make_shared<FileWatcher>("res/shaders");
+    }
 
     // Game
     blocks = Block::generateBlocks(modelShader, 10, 8);
     palette = make_shared<Palette>(modelShader);
     ball = make_shared<Ball>(modelShader, palette);
 
+    // Surface compile errors at startup rather than on first use
+    for (auto const &shader : {skyboxShader, textShader, modelShader,
+                               shadowShader, lightClusters->shader()}) {
+        shader->wait();
+    }
+    for (auto const &shader : postProcessing->shaders()) {
+        shader->wait();
+    }
+    for (auto const &shader : modelShaders->compiled()) {
+        shader->wait();
+    }
 }
 
 // //////////////////////////////////////////////////////////// Clean up //
 void cleanUp() {
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (!headless) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     palette = nullptr;
     ball = nullptr;
+    blocks.clear();
+
+    // The scene graph and the snapshots hold on to models too; whatever
+    // is still alive at resources::shutdown() is reported as a leak
+    scene.clear();
+    snapshots.clear();
 
     lightbulbShader = nullptr;
     modelShader = nullptr;
+    modelShaders = nullptr;
+    scene.modelShaders = nullptr;
+    lightClusters = nullptr;
+    scene.lightClusters = nullptr;
+    scene.drawData = nullptr;
     skyboxShader = nullptr;
     shadowShader = nullptr;
     textShader = nullptr;
+    shaderWatcher = nullptr;
 
     shadowMap = nullptr;
+    environment = nullptr;
+    postProcessing = nullptr;
+    dynamicResolution = nullptr;
     skybox = nullptr;
     ground = nullptr;
     lightbulb = nullptr;
     spotbulb = nullptr;
     teapot = nullptr;
     weird = nullptr;
+    Model::materialTable = nullptr;
 
     font = nullptr;
+    profiler = nullptr;
+    benchmark = nullptr;
+    regression = nullptr;
+    streamBuffer = nullptr;
+
+    resources::shutdown();
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (headless) {
+        headless = nullptr;
+    } else {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 }
 
 void resetGame(bool hard) {
@@ -1185,6 +1960,7 @@ void resetGame(bool hard) {
 
     for (auto const &block : blocks) {
         block->render = true;
+        block->flash = 0.0f;
     }
     palette->setBig();
     palette->positionTarget = vec3(0.0f, 0.0f, -25.0f);
@@ -1199,163 +1975,556 @@ void resetGame(bool hard) {
     yaw = -4.715f;
 }
 
-// /////////////////////////////////////////////////////////// Main loop //
-void performMainLoop() {
-    auto previousStartTime = sysclock::now();
+// ////////////////////////////////////////////////////////// Simulation //
+// One step of the game, on the main thread; what the renderer needs of
+// it is copied into the snapshot
+void simulate(float const deltaTime, FrameSnapshot &snapshot) {
+    snapshot.simulationStart = Profiler::clock::now();
 
-    while (!glfwWindowShouldClose(window) && !quitProgram) {
-        auto const startTime = sysclock::now();
-        sec const deltaTime = startTime - previousStartTime;
-        previousStartTime = startTime;
-
-        // --------------------------------------------------- Events -- //
+    // -------------------------------------------------------- Events -- //
+    if (!headless) {
+        // Dear ImGui's callbacks write its input
+        lock_guard<mutex> const lock(interfaceMutex);
         glfwPollEvents();
-        handleKeyboardInput(deltaTime.count());
+    }
+    if (benchmark) {
+        runBenchmarkScript();
+    } else if (regression) {
+        regression->scene().apply();
+    } else if (!headless) {
+        handleKeyboardInput(deltaTime);
+    }
 
-        // ----------------------------------- Get current frame size -- //
-        int displayWidth, displayHeight;
-        glfwMakeContextCurrent(window);
-        glfwGetFramebufferSize(window, &displayWidth,
-                               &displayHeight);
-
-        // Interpolate camera's properties
-        cameraPos = lerp(cameraPos, cameraPosTarget, 0.05f);
-        cameraFront = lerp(cameraFront, cameraFrontTarget, 0.05f);
-
-        // Interpolate game objects' movement
-        palette->position = lerp(palette->position,
-                                 palette->positionTarget, 0.5f);
-        palette->position.x = clamp(palette->position.x,
-                                    -(25.0f -
-                                      palette->dimensions.x / 2.0f),
-                                    (25.0f -
-                                     palette->dimensions.x / 2.0f));
-        palette->positionTarget.x = clamp(palette->positionTarget.x,
-                                          -(25.0f -
-                                            palette->dimensions.x / 2.0f),
-                                          (25.0f -
-                                           palette->dimensions.x / 2.0f));
-        ball->move(deltaTime.count(), palette);
-        ball->checkCollisions(blocks, palette);
-        if (ball->sticky) {
-            ball->position = palette->position +
-                             vec3(0.0f, 0.0f, palette->dimensions.y);
-        }
+    // ---------------------------------------- Get current frame size -- //
+    getFramebufferSize(snapshot.displayWidth, snapshot.displayHeight);
+
+    // Interpolate camera's properties
+    cameraPos = lerp(cameraPos, cameraPosTarget, 0.05f);
+    cameraFront = lerp(cameraFront, cameraFrontTarget, 0.05f);
+    if (benchmark) {
+        cameraPos = cameraPosTarget = benchmark->cameraPosition();
+        cameraFront = cameraFrontTarget = benchmark->cameraFront();
+    }
+
+    // Interpolate game objects' movement
+    palette->position = lerp(palette->position,
+                             palette->positionTarget, 0.5f);
+    palette->position.x = clamp(palette->position.x,
+                                -(25.0f -
+                                  palette->dimensions.x / 2.0f),
+                                (25.0f -
+                                 palette->dimensions.x / 2.0f));
+    palette->positionTarget.x = clamp(palette->positionTarget.x,
+                                      -(25.0f -
+                                        palette->dimensions.x / 2.0f),
+                                      (25.0f -
+                                       palette->dimensions.x / 2.0f));
+    ball->move(deltaTime, palette);
+    ball->checkCollisions(blocks, palette);
+    for (auto const &block : blocks) {
+        block->fade(deltaTime);
+    }
+    if (ball->sticky) {
+        ball->position = palette->position +
+                         vec3(0.0f, 0.0f, palette->dimensions.y);
+    }
+
+    // ------------------------------------------------------ Snapshot -- //
+    captureScene(snapshot);
+    gatherFlashLights(blocks, snapshot.flashLights);
+    snapshot.cameraPos = cameraPos;
+    snapshot.cameraFront = cameraFront;
+    snapshot.menu = menu;
+    snapshot.points = points;
+    snapshot.lives = lives;
+    snapshot.showUserInterface = showUserInterface;
+    snapshot.exportTrace = exportTraceRequested;
+    exportTraceRequested = false;
+
+    // The platform backend queries the window, which GLFW only allows
+    // on the main thread
+    if (showUserInterface && !headless) {
+        lock_guard<mutex> const lock(interfaceMutex);
+        ImGui_ImplGlfw_NewFrame();
+        captureInterfaceInput(snapshot);
+    }
 
+    snapshot.simulationEnd = Profiler::clock::now();
+}
 
-        // Scene graph
-        setupSceneGraph(deltaTime.count(), displayWidth,
-                        displayHeight);
+// /////////////////////////////////////////////////////////// Rendering //
+// Frame boundaries of everything that lives with the context
+void beginFrame() {
+    profiler->beginFrame();
+    stats::beginFrame();
+    resources::beginFrame();
+    streamBuffer->beginFrame();
+}
 
-        // ======================================== Render shadow map == //
-        // ------------------------------------------- Clear viewport -- //
+void endFrame() {
+    streamBuffer->endFrame();
+    resources::endFrame();
+    stats::endFrame();
+    profiler->endFrame();
+}
+
+// Draws a snapshot on whichever thread the context is current
+void renderFrame(FrameSnapshot const &snapshot) {
+    profiler->recordSimulation("Simulation", snapshot.simulationStart,
+                               snapshot.simulationEnd);
+    if (snapshot.exportTrace) {
+        profiler->exportChromeTrace(TRACE_FILENAME);
+    }
+    if (shaderWatcher) {
+        reloadChangedShaders();
+    }
+
+    int const displayWidth = snapshot.displayWidth;
+    int const displayHeight = snapshot.displayHeight;
+
+    // Scene graph
+    setupSceneGraph(snapshot);
+    scene.viewPosition = snapshot.cameraPos;
+
+    float const nearPlane = 0.01f, farPlane = 100.0f;
+    mat4 const projection = perspective(radians(60.0f),
+                                        ((float) displayWidth) /
+                                        ((float) displayHeight),
+                                        nearPlane, farPlane);
+    mat4 const view = lookAt(snapshot.cameraPos,
+                             snapshot.cameraPos + snapshot.cameraFront,
+                             cameraUp);
+    scene.lodProjectionScale = projection[1][1];
+
+    // ============================================= Render shadow map == //
+    static mat4 const lightProjection = glm::ortho(-100.0f, 100.0f,
+                                                   -100.0f, 100.0f,
+                                                   0.01f,
+                                                   200.0f);
+    mat4 const lightView = lookAt(
+            -50.0f * ImVec4ToVec3(lightDirectional.direction),
+            vec3(0.0f, 0.0f, 0.0f),
+            vec3(0.0f, 1.0f, 0.0f));
+
+    // The shadowless permutation never samples the map
+    if (shadowsEnabled) {
+        profiler->begin("Shadow pass");
+        stats::beginPass("Shadow pass");
+        // -------------------------------------------- Clear viewport -- //
         glViewport(0, 0, shadowMap->width, shadowMap->height);
-        glBindFramebuffer(GL_FRAMEBUFFER, shadowMap->depthMapFBO);
-        // {
+        glBindFramebuffer(GL_FRAMEBUFFER, shadowMap->depthMapFBO.id());
         glClear(GL_DEPTH_BUFFER_BIT);
 
-        // ----------------------------------- Set rendering mode -- //
+        // ---------------------------------------- Set rendering mode -- //
         glEnable(GL_DEPTH_TEST);
 
-        // ----------------------------------------- Render scene -- //
-        static mat4 const lightProjection = glm::ortho(-100.0f, 100.0f,
-                                                       -100.0f, 100.0f,
-                                                       0.01f,
-                                                       200.0f);
-        mat4 const lightView = lookAt(
-                -50.0f * ImVec4ToVec3(lightDirectional.direction),
-                vec3(0.0f, 0.0f, 0.0f),
-                vec3(0.0f, 1.0f, 0.0f));
-
+        // ---------------------------------------------- Render scene -- //
         scene.render(lightProjection * lightView, lightProjection,
                      lightView, mat4(1.0), shadowShader);
-        // }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        shadowPassCulled = scene.culled;
 
-        // ============================================= Render scene == //
-        // ------------------------------------------- Clear viewport -- //
-        glViewport(0, 0, displayWidth, displayHeight);
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer());
+        profiler->end("Shadow pass");
+    } else {
+        shadowPassCulled = 0;
+    }
 
-        // --------------------------------------- Set rendering mode -- //
-        glEnable(GL_DEPTH_TEST);
-        glPolygonMode(GL_FRONT_AND_BACK,
-                      wireframeMode ? GL_LINE : GL_FILL);
-
-        // --------------------------------------------- Render scene -- //
-        mat4 const projection = perspective(radians(60.0f),
-                                            ((float) displayWidth) /
-                                            ((float) displayHeight),
-                                            0.01f, 100.0f);
-        mat4 const view = lookAt(cameraPos,
-                                 cameraPos + cameraFront,
-                                 cameraUp);
-
-        glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, shadowMap->depthMapTexture);
-
-        scene.render(projection * view, projection, view,
-                     lightProjection * lightView);
-
-        // ----------------------------------------------------- Text -- //
-        // Enable blending
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-        std::stringstream s;
-        if (menu) {
-            s << "Breakout";
-            font->render(s.str(), 25.0f, displayHeight -
-                                         80.0f,//(displayHeight - 48) / 2.0f,
-                         1.0f, vec3(1.0f, 1.0f, 1.0f),
-                         displayWidth, displayHeight);
-            s.str(std::string());
-            s << "Tomasz Witczak | 216920";
-            font->render(s.str(), 35.0f, displayHeight -
-                                         110.0f,//(displayHeight - 48) / 2.0f,
-                         0.25f, vec3(1.0f, 1.0f, 1.0f),
-                         displayWidth, displayHeight);
-            s.str(std::string());
-            s << "Press [Enter] to play";
-            font->render(s.str(), 25.0f, displayHeight -
-                                         180.0f,//(displayHeight - 48) / 2.0f,
-                         0.5f, vec3(1.0f, 1.0f, 1.0f),
-                         displayWidth, displayHeight);
-            s.str(std::string());
-        } else {
-            s << "Points | " << points;
-            font->render(s.str(), 25.0f, displayHeight -
-                                         60.0f,//(displayHeight - 48) / 2.0f,
-                         0.5f, vec3(1.0f, 1.0f, 1.0f),
-                         displayWidth, displayHeight);
-            s.str(std::string());
-            s << "Lives | " << lives << "/" << maxLives;
-            font->render(s.str(), 25.0f, displayHeight -
-                                         120.0f,//(displayHeight - 48) / 2.0f,
-                         0.5f, vec3(1.0f, 1.0f, 1.0f),
-                         displayWidth, displayHeight);
+    // ================================================ Cluster lights == //
+    // Timings of the frame FRAME_LATENCY back were resolved above
+    if (dynamicResolution) {
+        renderScale = dynamicResolution->update(
+                profiler->latestGpuFrame());
+    }
+    postProcessing->resize(displayWidth, displayHeight, renderScale,
+                           dynamicResolution
+                           ? dynamicResolutionSettings.maxScale
+                           : renderScale);
+
+    profiler->begin("Light clusters");
+    stats::beginPass("Light clusters");
+    lightClusters->update(gatherClusterLights(snapshot.flashLights),
+                          view, projection,
+                          nearPlane, farPlane,
+                          postProcessing->width(),
+                          postProcessing->height());
+    profiler->end("Light clusters");
+
+    // ================================================== Render scene == //
+    profiler->begin("Main pass");
+    stats::beginPass("Main pass");
+
+    // ------------------------------------------------ Clear viewport -- //
+    postProcessing->begin();
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // -------------------------------------------- Set rendering mode -- //
+    glEnable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK,
+                  wireframeMode ? GL_LINE : GL_FILL);
+
+    // -------------------------------------------------- Render scene -- //
+    glActiveTexture(GL_TEXTURE6);
+    gl::bindTexture(GL_TEXTURE_2D, shadowMap->depthMapTexture.id());
+    environment->bind();
+
+    // TAA shifts every frame by a different sub-pixel offset
+    scene.jitter = postProcessing->jitter();
+    mat4 const jitteredProjection =
+            glm::translate(mat4(1.0f), vec3(scene.jitter, 0.0f)) *
+            projection;
+
+    scene.render(jitteredProjection * view, jitteredProjection, view,
+                 lightProjection * lightView);
+    mainPassCulled = scene.culled;
+
+    scene.previousVp = jitteredProjection * view;
+    scene.previousSkyboxVp = jitteredProjection * mat4(mat3(view));
+    scene.previousJitter = scene.jitter;
+    profiler->end("Main pass");
+
+    // =============================================== Post-processing == //
+    profiler->begin("Post-processing");
+    stats::beginPass("Post-processing");
+    postProcessing->end(defaultFramebuffer());
+    profiler->end("Post-processing");
+
+    // ---------------------------------------------------------- Text -- //
+    profiler->begin("Text");
+    stats::beginPass("Text");
+    // Enable blending
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    std::stringstream s;
+    if (snapshot.menu) {
+        s << "Breakout";
+        font->render(s.str(), 25.0f, displayHeight -
+                                     80.0f,//(displayHeight - 48) / 2.0f,
+                     1.0f, vec3(1.0f, 1.0f, 1.0f),
+                     displayWidth, displayHeight);
+        s.str(std::string());
+        s << "Tomasz Witczak | 216920";
+        font->render(s.str(), 35.0f, displayHeight -
+                                     110.0f,//(displayHeight - 48) / 2.0f,
+                     0.25f, vec3(1.0f, 1.0f, 1.0f),
+                     displayWidth, displayHeight);
+        s.str(std::string());
+        s << "Press [Enter] to play";
+        font->render(s.str(), 25.0f, displayHeight -
+                                     180.0f,//(displayHeight - 48) / 2.0f,
+                     0.5f, vec3(1.0f, 1.0f, 1.0f),
+                     displayWidth, displayHeight);
+        s.str(std::string());
+    } else {
+        s << "Points | " << snapshot.points;
+        font->render(s.str(), 25.0f, displayHeight -
+                                     60.0f,//(displayHeight - 48) / 2.0f,
+                     0.5f, vec3(1.0f, 1.0f, 1.0f),
+                     displayWidth, displayHeight);
+        s.str(std::string());
+        s << "Lives | " << snapshot.lives << "/" << maxLives;
+        font->render(s.str(), 25.0f, displayHeight -
+                                     120.0f,//(displayHeight - 48) / 2.0f,
+                     0.5f, vec3(1.0f, 1.0f, 1.0f),
+                     displayWidth, displayHeight);
+    }
+
+    glDisable(GL_BLEND);
+    profiler->end("Text");
+
+    // ------------------------------------------------------------ UI -- //
+    if (snapshot.showUserInterface && !headless) {
+        ProfileScope const scope(*profiler, "UI");
+        stats::beginPass("UI");
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+        // Drawing reads IO too, the framebuffer scale
+        lock_guard<mutex> const lock(interfaceMutex);
+        restoreInterfaceInput(snapshot);
+        prepareUserInterfaceWindow();
+        ImGui_ImplOpenGL3_RenderDrawData(
+                ImGui::GetDrawData());
+    }
+
+    // ------------------------------------------------- Update screen -- //
+    profiler->begin("Swap", false);
+    if (headless) {
+        glFlush();
+    } else {
+        glfwSwapBuffers(window);
+    }
+    profiler->end("Swap");
+}
+
+// /////////////////////////////////////////////////////////// Main loop //
+// Simulates a step and draws it right away. Benchmark, regression and
+// headless runs stay on one thread: their steps are fixed and their
+// frames are read back as soon as they are drawn.
+void performSequentialLoop() {
+    auto previousStartTime = sysclock::now();
+    FrameSnapshot snapshot;
+
+    int frame = 0;
+
+    while (!quitProgram && (headless || !glfwWindowShouldClose(window))) {
+        auto const startTime = sysclock::now();
+        sec deltaTime = startTime - previousStartTime;
+        previousStartTime = startTime;
+
+        // Benchmark simulates with a fixed timestep to stay repeatable
+        if (benchmark) {
+            deltaTime = sec(Benchmark::TIMESTEP);
+        }
+        // Regression scenes are still images
+        if (regression) {
+            deltaTime = sec(0.0f);
+        }
+
+        beginFrame();
+        simulate(deltaTime.count(), snapshot);
+        renderFrame(snapshot);
+        endFrame();
+
+        if (benchmark) {
+            float const frameTime = profiler->latestCpu("Frame");
+            benchmark->recordFrame(frameTime,
+                                   frameTime - profiler->latestCpu("Swap"),
+                                   profiler->latestGpuFrame(),
+                                   stats::lastFrame().total);
+            benchmark->advance();
+            quitProgram = quitProgram || benchmark->finished();
+        }
+
+        if (regression) {
+            regression->recordTiming(profiler->latestCpu("Frame"),
+                                     profiler->latestGpuFrame());
+            if (regression->capturing()) {
+                regression->recordFrame(headless->readFrame());
+            }
+            regression->advance();
+            quitProgram = quitProgram || regression->finished();
         }
 
-        glDisable(GL_BLEND);
+        // ------------------------------------------------ Dump frame -- //
+        if (headless && !frameDumpDirectory.empty()) {
+            stringstream filename;
+            filename << frameDumpDirectory << "/frame-"
+                     << std::setw(5) << std::setfill('0') << frame
+                     << ".ppm";
+            headless->saveFrame(filename.str());
+        }
 
-        // ------------------------------------------------------- UI -- //
-//        prepareUserInterfaceWindow();
-//        ImGui_ImplOpenGL3_RenderDrawData(
-//                ImGui::GetDrawData());
+        frame++;
+        if (frameLimit > 0 && frame >= frameLimit) {
+            quitProgram = true;
+        }
+    }
+}
 
-        // -------------------------------------------- Update screen -- //
+// Render thread: draws every snapshot the simulation publishes, until
+// told to stop or until drawing fails
+void performRenderLoop() {
+    try {
         glfwMakeContextCurrent(window);
-        glfwSwapBuffers(window);
+        for (;;) {
+            {
+                unique_lock<mutex> lock(pacingMutex);
+                pacing.wait(lock, []() {
+                    return snapshots.pending() || stopRendering;
+                });
+                if (stopRendering) {
+                    break;
+                }
+                snapshots.update();
+            }
+            // The simulation may go on with the next step
+            pacing.notify_one();
+
+            beginFrame();
+            renderFrame(snapshots.read());
+            endFrame();
+        }
+    } catch (...) {
+        renderError = std::current_exception();
+    }
+    glfwMakeContextCurrent(nullptr);
+
+    {
+        lock_guard<mutex> const lock(pacingMutex);
+        stopRendering = true;
+    }
+    pacing.notify_one();
+}
+
+// Wakes whichever thread waits for the other and lets the render
+// thread finish its frame, then takes the context back: clean-up deletes
+// objects on the main thread
+void stopRenderThread(thread &renderer) {
+    {
+        lock_guard<mutex> const lock(pacingMutex);
+        stopRendering = true;
+    }
+    pacing.notify_one();
+    renderer.join();
+    glfwMakeContextCurrent(window);
+}
+
+// Simulates on the main thread, which GLFW's events belong to, while
+// the render thread draws the step before. A step waits for the
+// renderer to take its snapshot before the next one starts, since the
+// game eases per step rather than per second; a frame then takes as
+// long as the slower of the two threads rather than both together.
+void performThreadedLoop() {
+    // The context moves to the render thread for the loop
+    glfwMakeContextCurrent(nullptr);
+    stopRendering = false;
+    thread renderer(performRenderLoop);
+
+    auto previousStartTime = sysclock::now();
+
+    int frame = 0;
+
+    try {
+        while (!quitProgram && !glfwWindowShouldClose(window) &&
+               !stopRendering) {
+            auto const startTime = sysclock::now();
+            sec const deltaTime = startTime - previousStartTime;
+            previousStartTime = startTime;
+
+            simulate(deltaTime.count(), snapshots.write());
+
+            {
+                unique_lock<mutex> lock(pacingMutex);
+                snapshots.publish();
+                pacing.notify_one();
+                pacing.wait(lock, []() {
+                    return !snapshots.pending() || stopRendering;
+                });
+            }
+
+            frame++;
+            if (frameLimit > 0 && frame >= frameLimit) {
+                quitProgram = true;
+            }
+        }
+    } catch (...) {
+        stopRenderThread(renderer);
+        throw;
+    }
+
+    stopRenderThread(renderer);
+    if (renderError) {
+        std::rethrow_exception(renderError);
+    }
+}
+
+void performMainLoop() {
+    if (renderThreadMode && !headless && !benchmark) {
+        performThreadedLoop();
+    } else {
+        performSequentialLoop();
+    }
+
+    if (benchmark) {
+        benchmark->writeResults();
+    }
+    if (regression) {
+        regression->writeResults();
+        if (regression->failures() > 0) {
+            throw runtime_error(std::to_string(regression->failures()) +
+                                " regression scene(s) differ from the "
+                                "references, see " +
+                                regressionSettings.output);
+        }
     }
 }
 
 // //////////////////////////////////////////////////////////////// Main //
-int main() {
+void parseArguments(int const argc, char const *const *argv) {
+    for (int i = 1; i < argc; ++i) {
+        string const argument = argv[i];
+
+        if (argument == "--stats-csv" && i + 1 < argc) {
+            stats::openCsv(argv[++i]);
+        } else if (argument == "--benchmark") {
+            benchmarkMode = true;
+        } else if (argument == "--benchmark-duration" && i + 1 < argc) {
+            benchmarkSettings.duration = std::stof(argv[++i]);
+        } else if (argument == "--benchmark-resolution" && i + 1 < argc) {
+            string const resolution = argv[++i];
+            size_t const separator = resolution.find('x');
+            if (separator == string::npos) {
+                throw runtime_error("Resolution must be WIDTHxHEIGHT");
+            }
+            benchmarkSettings.width =
+                    std::stoi(resolution.substr(0, separator));
+            benchmarkSettings.height =
+                    std::stoi(resolution.substr(separator + 1));
+        } else if (argument == "--benchmark-output" && i + 1 < argc) {
+            benchmarkSettings.output = argv[++i];
+        } else if (argument == "--regression") {
+            regressionMode = headlessMode = true;
+        } else if (argument == "--regression-update") {
+            regressionMode = headlessMode = true;
+            regressionSettings.update = true;
+        } else if (argument == "--regression-references" && i + 1 < argc) {
+            regressionSettings.references = argv[++i];
+        } else if (argument == "--regression-output" && i + 1 < argc) {
+            regressionSettings.output = argv[++i];
+        } else if (argument == "--headless") {
+            headlessMode = true;
+        } else if (argument == "--render-scale" && i + 1 < argc) {
+            renderScale = std::stof(argv[++i]);
+        } else if (argument == "--antialiasing" && i + 1 < argc) {
+            string const mode = argv[++i];
+            if (mode == "off") {
+                antialiasing = AA_OFF;
+            } else if (mode == "msaa") {
+                antialiasing = AA_MSAA;
+            } else if (mode == "taa") {
+                antialiasing = AA_TAA;
+            } else {
+                throw runtime_error("Anti-aliasing must be off, msaa or "
+                                    "taa");
+            }
+        } else if (argument == "--quantized-vertices") {
+            Mesh::quantizeVertices = true;
+        } else if (argument == "--dynamic-resolution") {
+            dynamicResolutionMode = true;
+        } else if (argument == "--dynamic-resolution-bounds" &&
+                   i + 1 < argc) {
+            string const bounds = argv[++i];
+            size_t const separator = bounds.find(':');
+            if (separator == string::npos) {
+                throw runtime_error("Bounds must be MIN:MAX");
+            }
+            dynamicResolutionSettings.minScale =
+                    std::stof(bounds.substr(0, separator));
+            dynamicResolutionSettings.maxScale =
+                    std::stof(bounds.substr(separator + 1));
+        } else if (argument == "--dynamic-resolution-budget" &&
+                   i + 1 < argc) {
+            dynamicResolutionSettings.budget = std::stof(argv[++i]);
+        } else if (argument == "--single-thread") {
+            renderThreadMode = false;
+        } else if (argument == "--frames" && i + 1 < argc) {
+            frameLimit = std::stoi(argv[++i]);
+        } else if (argument == "--dump-frames" && i + 1 < argc) {
+            frameDumpDirectory = argv[++i];
+        } else {
+            throw runtime_error(("Unknown argument: " + argument).c_str());
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
     try {
+        parseArguments(argc, argv);
         setupOpenGL();
         performMainLoop();
         cleanUp();
+        stats::closeCsv();
     } catch (exception const &exception) {
         cerr << exception.what();
         return 1;
@@ -0,0 +1,123 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "material-table.hpp"
+#include "material.hpp"
+#include "frame-stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::string;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    gl::Texture createArray(GLenum const internalFormat, int const width,
+                            int const height, int const levels,
+                            int const layers) {
+        gl::Texture texture(GL_TEXTURE_2D_ARRAY, levels, internalFormat,
+                            width, height, layers);
+        texture.parameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+        texture.parameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
+        texture.parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        texture.parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return texture;
+    }
+
+    // Moves the first layers of every level into a larger array; the old
+    // one is deleted once frames already drawn with it are done
+    void grow(gl::Texture &texture, GLenum const internalFormat,
+              int const width, int const height, int const levels,
+              int const layers, int const capacity) {
+        gl::Texture grown = createArray(internalFormat, width, height,
+                                        levels, capacity);
+        if (texture.id() != 0) {
+            for (int level = 0; level < levels; ++level) {
+                glCopyImageSubData(texture.id(), GL_TEXTURE_2D_ARRAY, level,
+                                   0, 0, 0,
+                                   grown.id(), GL_TEXTURE_2D_ARRAY, level,
+                                   0, 0, 0,
+                                   std::max(width >> level, 1),
+                                   std::max(height >> level, 1), layers);
+            }
+        }
+        texture = std::move(grown);
+    }
+
+    void uploadLayer(gl::Texture &texture, int const layer,
+                     material::Image const &image) {
+        texture.upload(0, 0, 0, layer, image.width, image.height, 1,
+                       GL_RGB, GL_UNSIGNED_BYTE, image.pixels.data());
+        texture.generateMipmap();
+    }
+}
+
+// //////////////////////////////////////////////// Class: MaterialTable //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+MaterialTable::MaterialTable()
+        : width(0), height(0), levels(0), count(0), capacity(0) {
+}
+
+int MaterialTable::add(string const &directory) {
+    auto const found = indices.find(directory);
+    if (found != indices.end()) {
+        return found->second;
+    }
+
+    material::Image albedoImage = material::loadImage(
+            directory + material::ALBEDO_FILE);
+    if (count == 0) {
+        width = albedoImage.width;
+        height = albedoImage.height;
+        levels = 1 + static_cast<int>(
+                std::floor(std::log2(std::max(width, height))));
+    }
+    if (count == capacity) {
+        reserve(std::max(INITIAL_CAPACITY, 2 * capacity));
+    }
+
+    // Rows of three bytes aren't 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    uploadLayer(albedo, count,
+                material::resize(albedoImage, width, height));
+    uploadLayer(orm, count,
+                material::resize(material::loadOrm(directory),
+                                 width, height));
+    uploadLayer(normal, count,
+                material::resize(material::loadImage(
+                                         directory + material::NORMAL_FILE),
+                                 width, height));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    indices[directory] = count;
+    return count++;
+}
+
+int MaterialTable::size() const {
+    return count;
+}
+
+void MaterialTable::bind() const {
+    glActiveTexture(GL_TEXTURE0 + ALBEDO_UNIT);
+    gl::bindTexture(GL_TEXTURE_2D_ARRAY, albedo.id());
+    glActiveTexture(GL_TEXTURE0 + ORM_UNIT);
+    gl::bindTexture(GL_TEXTURE_2D_ARRAY, orm.id());
+    glActiveTexture(GL_TEXTURE0 + NORMAL_UNIT);
+    gl::bindTexture(GL_TEXTURE_2D_ARRAY, normal.id());
+}
+
+// ============================================= Private implementation ==
+// ----------------------------------------------------------- Behaviour --
+void MaterialTable::reserve(int const layers) {
+    // Mipmaps are generated, which GL only guarantees for formats that
+    // are colour-renderable; SRGB8 isn't, SRGB8_ALPHA8 is. The images
+    // stay three channels, alpha is filled with one on upload
+    grow(albedo, GL_SRGB8_ALPHA8, width, height, levels, count, layers);
+    grow(orm, GL_RGB8, width, height, levels, count, layers);
+    grow(normal, GL_RGB8, width, height, levels, count, layers);
+    capacity = layers;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,53 @@
+#ifndef MATERIAL_TABLE_H
+#define MATERIAL_TABLE_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "opengl-headers.hpp"
+#include "gl-resources.hpp"
+
+#include <string>
+#include <unordered_map>
+
+// //////////////////////////////////////////////// Class: MaterialTable //
+// Every material's maps as layers of three 2D array textures: albedo
+// (sRGB), packed occlusion/roughness/metalness and normals. They stay
+// bound for the whole pass and each draw picks its layer by the material
+// index in its per-draw data, so switching materials costs no binds and
+// doesn't split instanced draws. Layers share one size, that of the
+// first material; later ones are resampled to it.
+class MaterialTable {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    // Texture units the model shader samples the arrays from
+    static constexpr int ALBEDO_UNIT = 0;
+    static constexpr int ORM_UNIT = 1;
+    static constexpr int NORMAL_UNIT = 2;
+
+    static constexpr int INITIAL_CAPACITY = 4;
+
+    // ------------------------------------------------------- Behaviour --
+    MaterialTable();
+
+    MaterialTable(MaterialTable const &) = delete;
+    MaterialTable &operator=(MaterialTable const &) = delete;
+
+    // Index of the material in the directory, loaded on first use
+    int add(std::string const &directory);
+
+    int size() const;
+
+    void bind() const;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------- Behaviour --
+    // Reallocates the arrays, keeping the loaded layers
+    void reserve(int const layers);
+
+    // ------------------------------------------------------------ Data --
+    std::unordered_map<std::string, int> indices;
+    int width, height, levels;
+    int count, capacity;
+    gl::Texture albedo, orm, normal;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // MATERIAL_TABLE_H
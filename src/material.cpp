@@ -0,0 +1,171 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "material.hpp"
+#include "cache.hpp"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+using material::Image;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    struct CacheHeader {
+        std::uint32_t magic;
+        std::uint32_t width;
+        std::uint32_t height;
+    };
+
+    std::uint32_t const CACHE_MAGIC = 0x4d524f01u;
+
+    int const CHANNELS = 3;
+
+    std::size_t imageBytes(int const width, int const height) {
+        return static_cast<std::size_t>(width) * height * CHANNELS;
+    }
+
+    // Flipped like every texture of the models
+    Image load(string const &filename, int const channels) {
+        stbi_set_flip_vertically_on_load(true);
+
+        int width, height, fileChannels;
+        unsigned char *data = stbi_load(filename.c_str(), &width, &height,
+                                        &fileChannels, channels);
+        if (data == nullptr) {
+            throw runtime_error("Failed to load texture!");
+        }
+
+        Image image = {width, height, vector<unsigned char>(
+                data, data + static_cast<std::size_t>(width) * height *
+                             channels)};
+        stbi_image_free(data);
+        return image;
+    }
+
+    string cacheFile(string const &directory) {
+        string const cacheDirectory = cache::directory("materials");
+        if (cacheDirectory.empty()) {
+            return string();
+        }
+
+        std::uint64_t key = cache::hash(&CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        vector<char> data;
+        for (char const *map : material::ORM_FILES) {
+            if (!cache::read(directory + map, data)) {
+                return string();
+            }
+            key = cache::hash(data.data(), data.size(), key);
+        }
+        return cacheDirectory + "/" + cache::hex(key) + ".bin";
+    }
+
+    bool loadCache(string const &filename, Image &image) {
+        vector<char> data;
+        if (filename.empty() || !cache::read(filename, data) ||
+            data.size() < sizeof(CacheHeader)) {
+            return false;
+        }
+
+        CacheHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (header.magic != CACHE_MAGIC ||
+            data.size() != sizeof(header) +
+                           imageBytes(header.width, header.height)) {
+            return false;
+        }
+
+        image.width = static_cast<int>(header.width);
+        image.height = static_cast<int>(header.height);
+        image.pixels.assign(data.begin() + sizeof(header), data.end());
+        return true;
+    }
+
+    void saveCache(string const &filename, Image const &image) {
+        if (filename.empty()) {
+            return;
+        }
+
+        CacheHeader const header = {
+                CACHE_MAGIC, static_cast<std::uint32_t>(image.width),
+                static_cast<std::uint32_t>(image.height)};
+        vector<char> data(sizeof(header));
+        std::memcpy(data.data(), &header, sizeof(header));
+        data.insert(data.end(), image.pixels.begin(), image.pixels.end());
+        cache::write(filename, data);
+    }
+
+    Image bake(string const &directory) {
+        Image channels[CHANNELS];
+        Image orm = {0, 0, {}};
+        for (int channel = 0; channel < CHANNELS; ++channel) {
+            channels[channel] = load(directory + material::ORM_FILES[channel],
+                                     1);
+            orm.width = std::max(orm.width, channels[channel].width);
+            orm.height = std::max(orm.height, channels[channel].height);
+        }
+
+        orm.pixels.resize(imageBytes(orm.width, orm.height));
+        for (int channel = 0; channel < CHANNELS; ++channel) {
+            Image const &image = channels[channel];
+            for (int y = 0; y < orm.height; ++y) {
+                int const sourceY = y * image.height / orm.height;
+                for (int x = 0; x < orm.width; ++x) {
+                    int const sourceX = x * image.width / orm.width;
+                    orm.pixels[(static_cast<std::size_t>(y) * orm.width + x) *
+                               CHANNELS + channel] =
+                            image.pixels[static_cast<std::size_t>(sourceY) *
+                                         image.width + sourceX];
+                }
+            }
+        }
+        return orm;
+    }
+}
+
+// ///////////////////////////////////////////////////// Material images //
+Image material::loadImage(string const &filename) {
+    return load(filename, CHANNELS);
+}
+
+Image material::loadOrm(string const &directory) {
+    Image orm;
+    string const filename = cacheFile(directory);
+    if (!loadCache(filename, orm)) {
+        orm = bake(directory);
+        saveCache(filename, orm);
+    }
+    return orm;
+}
+
+Image material::resize(Image const &image, int const width,
+                       int const height) {
+    if (image.width == width && image.height == height) {
+        return image;
+    }
+
+    Image resized = {width, height,
+                     vector<unsigned char>(imageBytes(width, height))};
+    for (int y = 0; y < height; ++y) {
+        int const sourceY = y * image.height / height;
+        for (int x = 0; x < width; ++x) {
+            int const sourceX = x * image.width / width;
+            std::memcpy(&resized.pixels[imageBytes(y * width + x, 1)],
+                        &image.pixels[imageBytes(sourceY * image.width +
+                                                 sourceX, 1)],
+                        CHANNELS);
+        }
+    }
+    return resized;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
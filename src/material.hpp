@@ -0,0 +1,37 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+// //////////////////////////////////////////////////////////// Includes //
+#include <string>
+#include <vector>
+
+// ///////////////////////////////////////////////////// Material images //
+// A material directory holds albedo.jpg, normal.jpg and one greyscale
+// image per scalar: ao.jpg, roughness.jpg and metalness.jpg. The scalars
+// are baked into the channels of one image, in glTF's order, so the
+// model shader reads them with one fetch.
+namespace material {
+    char const *const ALBEDO_FILE = "/albedo.jpg";
+    char const *const NORMAL_FILE = "/normal.jpg";
+
+    // Occlusion, roughness, metalness: red, green, blue
+    char const *const ORM_FILES[] = {
+            "/ao.jpg", "/roughness.jpg", "/metalness.jpg"};
+
+    // Three channels per pixel, rows bottom to top like OpenGL expects
+    struct Image {
+        int width, height;
+        std::vector<unsigned char> pixels;
+    };
+
+    Image loadImage(std::string const &filename);
+
+    // Packed on first use and cached on disk, keyed by the three images;
+    // images of different sizes are resampled to the largest
+    Image loadOrm(std::string const &directory);
+
+    // Nearest-neighbour resampling
+    Image resize(Image const &image, int const width, int const height);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // MATERIAL_H
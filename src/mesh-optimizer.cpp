@@ -0,0 +1,615 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "mesh-optimizer.hpp"
+#include "cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::size_t;
+using std::vector;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    // Forsyth's scoring assumes a larger cache than the one measured
+    int const SCORING_CACHE_SIZE = 32;
+    float const CACHE_DECAY_POWER = 1.5f;
+    float const LAST_TRIANGLE_SCORE = 0.75f;
+    float const VALENCE_BOOST_SCALE = 2.0f;
+    float const VALENCE_BOOST_POWER = 0.5f;
+
+    float vertexScore(int const cachePosition, int const remaining) {
+        if (remaining == 0) {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            // The latest triangle's vertices get a fixed score, so that
+            // it isn't immediately followed by a triangle sharing its edge
+            score = cachePosition < 3
+                    ? LAST_TRIANGLE_SCORE
+                    : std::pow(1.0f - static_cast<float>(cachePosition - 3) /
+                                      (SCORING_CACHE_SIZE - 3),
+                               CACHE_DECAY_POWER);
+        }
+
+        // Prefer vertices with few triangles left, not to strand them
+        return score + VALENCE_BOOST_SCALE *
+                       std::pow(static_cast<float>(remaining),
+                                -VALENCE_BOOST_POWER);
+    }
+
+    struct VertexHash {
+        size_t operator()(Vertex const &vertex) const {
+            return static_cast<size_t>(cache::hash(&vertex, sizeof(Vertex)));
+        }
+    };
+
+    struct VertexEqual {
+        bool operator()(Vertex const &a, Vertex const &b) const {
+            return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+        }
+    };
+
+    // Simplification stops below this share of the triangles it
+    // started a level with, the level wouldn't be worth drawing
+    float const LOD_MIN_REDUCTION = 0.8f;
+
+    // Symmetric 4x4 matrix of the squared distance to a set of planes
+    struct Quadric {
+        double xx, xy, xz, xw, yy, yz, yw, zz, zw, ww;
+
+        Quadric() : xx(0), xy(0), xz(0), xw(0), yy(0), yz(0), yw(0),
+                    zz(0), zw(0), ww(0) {}
+
+        // Plane through point with the given unit normal
+        Quadric(glm::vec3 const &normal, glm::vec3 const &point,
+                double const weight) {
+            double const a = normal.x, b = normal.y, c = normal.z;
+            double const d = -glm::dot(normal, point);
+            xx = weight * a * a; xy = weight * a * b; xz = weight * a * c;
+            xw = weight * a * d; yy = weight * b * b; yz = weight * b * c;
+            yw = weight * b * d; zz = weight * c * c; zw = weight * c * d;
+            ww = weight * d * d;
+        }
+
+        Quadric &operator+=(Quadric const &q) {
+            xx += q.xx; xy += q.xy; xz += q.xz; xw += q.xw; yy += q.yy;
+            yz += q.yz; yw += q.yw; zz += q.zz; zw += q.zw; ww += q.ww;
+            return *this;
+        }
+
+        double error(glm::vec3 const &p) const {
+            double const x = p.x, y = p.y, z = p.z;
+            return xx * x * x + 2 * xy * x * y + 2 * xz * x * z +
+                   2 * xw * x + yy * y * y + 2 * yz * y * z + 2 * yw * y +
+                   zz * z * z + 2 * zw * z + ww;
+        }
+    };
+
+    struct PositionHash {
+        size_t operator()(glm::vec3 const &position) const {
+            return static_cast<size_t>(
+                    cache::hash(&position, sizeof(position)));
+        }
+    };
+
+    struct Collapse {
+        unsigned int from, to;
+        double cost;
+    };
+}
+
+// /////////////////////////////////////////////////////// Mesh optimizer //
+optimizer::Report optimizer::optimize(vector<Vertex> &vertices,
+                                      vector<unsigned int> &indices) {
+    Report report;
+    report.verticesBefore = vertices.size();
+    report.acmrBefore = acmr(indices, vertices.size());
+
+    weldVertices(vertices, indices);
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+
+    report.verticesAfter = vertices.size();
+    report.acmrAfter = acmr(indices, vertices.size());
+    return report;
+}
+
+void optimizer::weldVertices(vector<Vertex> &vertices,
+                             vector<unsigned int> &indices) {
+    std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+    unique.reserve(vertices.size());
+
+    vector<Vertex> welded;
+    vector<unsigned int> remap(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        auto const inserted = unique.emplace(
+                vertices[i], static_cast<unsigned int>(welded.size()));
+        if (inserted.second) {
+            welded.push_back(vertices[i]);
+        }
+        remap[i] = inserted.first->second;
+    }
+
+    for (unsigned int &index : indices) {
+        index = remap[index];
+    }
+    vertices.swap(welded);
+}
+
+void optimizer::optimizeVertexCache(vector<unsigned int> &indices,
+                                    size_t const vertexCount) {
+    size_t const triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Triangles of each vertex, packed into one array; the first
+    // remaining[v] entries of a vertex's range are not emitted yet
+    vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (unsigned int const index : indices) {
+        offsets[index + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    vector<unsigned int> adjacency(indices.size());
+    vector<int> remaining(vertexCount, 0);
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        for (int corner = 0; corner < 3; ++corner) {
+            unsigned int const vertex = indices[3 * triangle + corner];
+            adjacency[offsets[vertex] + remaining[vertex]++] =
+                    static_cast<unsigned int>(triangle);
+        }
+    }
+
+    vector<int> cachePosition(vertexCount, -1);
+    vector<float> vertexScores(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        vertexScores[vertex] = vertexScore(-1, remaining[vertex]);
+    }
+
+    vector<float> triangleScores(triangleCount);
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        triangleScores[triangle] = vertexScores[indices[3 * triangle]] +
+                                   vertexScores[indices[3 * triangle + 1]] +
+                                   vertexScores[indices[3 * triangle + 2]];
+    }
+
+    vector<char> emitted(triangleCount, 0);
+    vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    vector<unsigned int> cache, nextCache;
+    size_t scan = 0;
+    long best = std::max_element(triangleScores.begin(),
+                                 triangleScores.end()) -
+                triangleScores.begin();
+
+    while (result.size() < indices.size()) {
+        // Nothing in the cache has triangles left: restart anywhere
+        if (best < 0) {
+            while (emitted[scan]) {
+                ++scan;
+            }
+            best = static_cast<long>(scan);
+        }
+        emitted[best] = 1;
+
+        nextCache.clear();
+        for (int corner = 0; corner < 3; ++corner) {
+            unsigned int const vertex = indices[3 * best + corner];
+            result.push_back(vertex);
+            nextCache.push_back(vertex);
+
+            unsigned int *const begin = &adjacency[offsets[vertex]];
+            unsigned int *const end = begin + remaining[vertex];
+            std::iter_swap(std::find(begin, end,
+                                     static_cast<unsigned int>(best)),
+                           end - 1);
+            remaining[vertex]--;
+        }
+        for (unsigned int const vertex : cache) {
+            if (std::find(nextCache.begin(), nextCache.end(), vertex) ==
+                nextCache.end()) {
+                nextCache.push_back(vertex);
+            }
+        }
+
+        // Rescore everything that moved in or dropped out of the cache,
+        // then the triangles around it
+        for (size_t i = 0; i < nextCache.size(); ++i) {
+            unsigned int const vertex = nextCache[i];
+            cachePosition[vertex] = static_cast<int>(i) < SCORING_CACHE_SIZE
+                                    ? static_cast<int>(i) : -1;
+            vertexScores[vertex] = vertexScore(cachePosition[vertex],
+                                               remaining[vertex]);
+        }
+
+        best = -1;
+        float bestScore = -1.0f;
+        for (unsigned int const vertex : nextCache) {
+            for (int i = 0; i < remaining[vertex]; ++i) {
+                unsigned int const triangle = adjacency[offsets[vertex] + i];
+                float const score =
+                        vertexScores[indices[3 * triangle]] +
+                        vertexScores[indices[3 * triangle + 1]] +
+                        vertexScores[indices[3 * triangle + 2]];
+                triangleScores[triangle] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = triangle;
+                }
+            }
+        }
+
+        if (nextCache.size() > SCORING_CACHE_SIZE) {
+            nextCache.resize(SCORING_CACHE_SIZE);
+        }
+        cache.swap(nextCache);
+    }
+
+    indices.swap(result);
+}
+
+void optimizer::optimizeOverdraw(vector<unsigned int> &indices,
+                                 vector<Vertex> const &vertices,
+                                 float const threshold) {
+    size_t const triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+    float const target = threshold * acmr(indices, vertices.size());
+
+    // A cluster starts where the cache runs cold anyway (every vertex
+    // missed), or where the cluster so far, simulated from a cold cache,
+    // is already as good as the whole mesh, so that drawing it in any
+    // order costs little. Two simulations: the mesh's and the cluster's.
+    vector<size_t> clusters;
+    vector<unsigned int> meshStamps(vertices.size(), 0);
+    vector<unsigned int> clusterStamps(vertices.size(), 0);
+    unsigned int meshCounter = CACHE_SIZE + 1;
+    unsigned int clusterCounter = CACHE_SIZE + 1;
+    size_t clusterStart = 0, clusterMisses = 0;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        int meshMisses = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            unsigned int const vertex = indices[3 * triangle + corner];
+            if (meshCounter - meshStamps[vertex] > CACHE_SIZE) {
+                meshStamps[vertex] = meshCounter++;
+                meshMisses++;
+            }
+        }
+
+        if (triangle == 0 || meshMisses == 3 ||
+            static_cast<float>(clusterMisses) /
+            (triangle - clusterStart) <= target) {
+            clusters.push_back(triangle);
+            clusterStart = triangle;
+            clusterMisses = 0;
+
+            // Empties the cluster's cache
+            clusterCounter += CACHE_SIZE + 1;
+        }
+
+        for (int corner = 0; corner < 3; ++corner) {
+            unsigned int const vertex = indices[3 * triangle + corner];
+            if (clusterCounter - clusterStamps[vertex] > CACHE_SIZE) {
+                clusterStamps[vertex] = clusterCounter++;
+                clusterMisses++;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // Area-weighted centroid and normal of the mesh and each cluster
+    struct Cluster {
+        size_t begin, end;
+        float sortKey;
+    };
+    vector<Cluster> sorted;
+    vector<glm::vec3> centroids, normals;
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t i = 0; i + 1 < clusters.size(); ++i) {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t triangle = clusters[i]; triangle < clusters[i + 1];
+             ++triangle) {
+            glm::vec3 const &a = vertices[indices[3 * triangle]].position;
+            glm::vec3 const &b = vertices[indices[3 * triangle + 1]].position;
+            glm::vec3 const &c = vertices[indices[3 * triangle + 2]].position;
+
+            glm::vec3 const cross = glm::cross(b - a, c - a);
+            float const triangleArea = 0.5f * glm::length(cross);
+            centroid += triangleArea * (a + b + c) / 3.0f;
+            normal += cross;
+            area += triangleArea;
+        }
+
+        meshCentroid += centroid;
+        meshArea += area;
+        centroids.push_back(area > 0.0f ? centroid / area : centroid);
+        normals.push_back(glm::length(normal) > 0.0f
+                          ? glm::normalize(normal) : normal);
+        sorted.push_back({clusters[i], clusters[i + 1], 0.0f});
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    // Clusters facing away from the centre tend to occlude the others
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        sorted[i].sortKey = glm::dot(centroids[i] - meshCentroid,
+                                     normals[i]);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](Cluster const &a, Cluster const &b) {
+                         return a.sortKey > b.sortKey;
+                     });
+
+    vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (Cluster const &cluster : sorted) {
+        result.insert(result.end(), indices.begin() + 3 * cluster.begin,
+                      indices.begin() + 3 * cluster.end);
+    }
+    indices.swap(result);
+}
+
+void optimizer::optimizeVertexFetch(vector<Vertex> &vertices,
+                                    vector<unsigned int> &indices) {
+    unsigned int const unused = ~0u;
+    vector<unsigned int> remap(vertices.size(), unused);
+    vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+
+    for (unsigned int &index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = static_cast<unsigned int>(ordered.size());
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    // Vertices no triangle references are dropped
+    vertices.swap(ordered);
+}
+
+vector<unsigned int> optimizer::simplify(vector<Vertex> const &vertices,
+                                         vector<unsigned int> const &indices,
+                                         size_t const targetIndexCount) {
+    size_t const vertexCount = vertices.size();
+
+    // Vertices sharing a position differ in other attributes: moving one
+    // of them would tear the seam open
+    std::unordered_map<glm::vec3, unsigned int, PositionHash> positions;
+    vector<unsigned int> positionIds(vertexCount);
+    vector<int> positionUses;
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        auto const inserted = positions.emplace(
+                vertices[vertex].position,
+                static_cast<unsigned int>(positionUses.size()));
+        if (inserted.second) {
+            positionUses.push_back(0);
+        }
+        positionIds[vertex] = inserted.first->second;
+        positionUses[positionIds[vertex]]++;
+    }
+
+    // Border edges have no opposite half-edge
+    std::unordered_map<std::uint64_t, int> edges;
+    auto const edgeKey = [&positionIds](unsigned int const a,
+                                        unsigned int const b) {
+        return static_cast<std::uint64_t>(positionIds[a]) << 32u |
+               positionIds[b];
+    };
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        for (int corner = 0; corner < 3; ++corner) {
+            edges[edgeKey(indices[i + corner],
+                          indices[i + (corner + 1) % 3])]++;
+        }
+    }
+
+    vector<char> lockedPositions(positionUses.size(), 0);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        for (int corner = 0; corner < 3; ++corner) {
+            unsigned int const a = indices[i + corner];
+            unsigned int const b = indices[i + (corner + 1) % 3];
+            if (edges.find(edgeKey(b, a)) == edges.end()) {
+                lockedPositions[positionIds[a]] = 1;
+                lockedPositions[positionIds[b]] = 1;
+            }
+        }
+    }
+
+    vector<char> locked(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        locked[vertex] = positionUses[positionIds[vertex]] > 1 ||
+                         lockedPositions[positionIds[vertex]];
+    }
+
+    // Area-weighted planes of the triangles around each vertex
+    vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        glm::vec3 const &a = vertices[indices[i]].position;
+        glm::vec3 const &b = vertices[indices[i + 1]].position;
+        glm::vec3 const &c = vertices[indices[i + 2]].position;
+        glm::vec3 const cross = glm::cross(b - a, c - a);
+        float const length = glm::length(cross);
+        if (length == 0.0f) {
+            continue;
+        }
+        Quadric const plane(cross / length, a, 0.5 * length);
+        for (int corner = 0; corner < 3; ++corner) {
+            quadrics[indices[i + corner]] += plane;
+        }
+    }
+
+    vector<unsigned int> result(indices.begin(),
+                                indices.end() - indices.size() % 3);
+    vector<unsigned int> offsets, adjacency, target(vertexCount);
+    vector<char> touched(vertexCount);
+    vector<Collapse> collapses;
+
+    // Each pass collapses the cheapest edges whose neighbourhoods don't
+    // overlap, so every collapse is checked against the current mesh
+    while (result.size() > targetIndexCount) {
+        size_t const triangleCount = result.size() / 3;
+
+        offsets.assign(vertexCount + 1, 0);
+        for (unsigned int const index : result) {
+            offsets[index + 1]++;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        adjacency.resize(result.size());
+        vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < result.size(); ++i) {
+            adjacency[fill[result[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+
+        // Interior edges are seen from both triangles, so one direction
+        // per triangle covers both
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); ++i) {
+            unsigned int const from = result[i];
+            unsigned int const to = result[i - i % 3 + (i + 1) % 3];
+            if (locked[from]) {
+                continue;
+            }
+            Quadric sum = quadrics[from];
+            sum += quadrics[to];
+            collapses.push_back(
+                    {from, to, sum.error(vertices[to].position)});
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](Collapse const &a, Collapse const &b) {
+                      return a.cost < b.cost;
+                  });
+
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+            target[vertex] = static_cast<unsigned int>(vertex);
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+
+        // A collapse removes about two triangles
+        size_t const wanted = (triangleCount - targetIndexCount / 3 + 1) / 2;
+        size_t performed = 0;
+        for (Collapse const &collapse : collapses) {
+            if (performed >= wanted) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // Reject collapses that flip a triangle around the vertex
+            glm::vec3 const &moved = vertices[collapse.to].position;
+            bool flips = false;
+            for (unsigned int k = offsets[collapse.from];
+                 k < offsets[collapse.from + 1] && !flips; ++k) {
+                unsigned int const *triangle = &result[3 * adjacency[k]];
+                if (triangle[0] == collapse.to ||
+                    triangle[1] == collapse.to ||
+                    triangle[2] == collapse.to) {
+                    continue;
+                }
+                glm::vec3 before[3], after[3];
+                for (int corner = 0; corner < 3; ++corner) {
+                    before[corner] = vertices[triangle[corner]].position;
+                    after[corner] = triangle[corner] == collapse.from
+                                    ? moved : before[corner];
+                }
+                flips = glm::dot(glm::cross(before[1] - before[0],
+                                            before[2] - before[0]),
+                                 glm::cross(after[1] - after[0],
+                                            after[2] - after[0])) <= 0.0f;
+            }
+            if (flips) {
+                continue;
+            }
+
+            target[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            for (unsigned int k = offsets[collapse.from];
+                 k < offsets[collapse.from + 1]; ++k) {
+                for (int corner = 0; corner < 3; ++corner) {
+                    touched[result[3 * adjacency[k] + corner]] = 1;
+                }
+            }
+            performed++;
+        }
+        if (performed == 0) {
+            break;
+        }
+
+        // Drop the triangles that collapsed into lines
+        size_t kept = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            unsigned int const a = target[result[i]];
+            unsigned int const b = target[result[i + 1]];
+            unsigned int const c = target[result[i + 2]];
+            if (a != b && b != c && c != a) {
+                result[kept++] = a;
+                result[kept++] = b;
+                result[kept++] = c;
+            }
+        }
+        result.resize(kept);
+    }
+    return result;
+}
+
+vector<unsigned int> optimizer::generateLods(vector<Vertex> const &vertices,
+                                             vector<unsigned int> &indices) {
+    vector<unsigned int> offsets = {0};
+    vector<unsigned int> previous(indices);
+    for (int lod = 1; lod < LOD_COUNT; ++lod) {
+        size_t const target = static_cast<size_t>(
+                previous.size() / 3 * LOD_REDUCTION) * 3;
+        vector<unsigned int> simplified =
+                simplify(vertices, previous, target);
+        if (simplified.empty() ||
+            simplified.size() > previous.size() * LOD_MIN_REDUCTION) {
+            break;
+        }
+        optimizeVertexCache(simplified, vertices.size());
+
+        offsets.push_back(static_cast<unsigned int>(indices.size()));
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        previous.swap(simplified);
+    }
+    offsets.push_back(static_cast<unsigned int>(indices.size()));
+    return offsets;
+}
+
+float optimizer::acmr(vector<unsigned int> const &indices,
+                      size_t const vertexCount, int const cacheSize) {
+    size_t const triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+
+    // FIFO: a vertex is cached while fewer than cacheSize misses
+    // happened since it was loaded
+    vector<unsigned int> stamps(vertexCount, 0);
+    unsigned int counter = cacheSize + 1;
+    size_t misses = 0;
+    for (unsigned int const index : indices) {
+        if (counter - stamps[index] > static_cast<unsigned int>(cacheSize)) {
+            stamps[index] = counter++;
+            misses++;
+        }
+    }
+    return static_cast<float>(misses) / triangleCount;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
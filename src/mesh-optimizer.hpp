@@ -0,0 +1,75 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "mesh.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// /////////////////////////////////////////////////////// Mesh optimizer //
+// Import-time reordering of indexed triangle lists. optimize() runs the
+// stages in order: welding, vertex cache, overdraw, vertex fetch.
+namespace optimizer {
+    // FIFO entries of the post-transform cache simulated for ACMR
+    int const CACHE_SIZE = 16;
+
+    // Overdraw ordering may cost at most this factor of ACMR
+    float const OVERDRAW_THRESHOLD = 1.05f;
+
+    // Levels of detail including the full mesh; each keeps this share of
+    // the previous one's triangles
+    int const LOD_COUNT = 4;
+    float const LOD_REDUCTION = 0.5f;
+
+    struct Report {
+        std::size_t verticesBefore, verticesAfter;
+        float acmrBefore, acmrAfter;
+    };
+
+    Report optimize(std::vector<Vertex> &vertices,
+                    std::vector<unsigned int> &indices);
+
+    // Merges bitwise identical vertices and rewrites the indices
+    void weldVertices(std::vector<Vertex> &vertices,
+                      std::vector<unsigned int> &indices);
+
+    // Forsyth's linear-speed ordering: greedily emits the triangle whose
+    // vertices score best for cache recency and remaining valence
+    void optimizeVertexCache(std::vector<unsigned int> &indices,
+                             std::size_t const vertexCount);
+
+    // Cuts the cache-ordered triangles into clusters where ACMR allows
+    // and sorts them outward-facing first, after Sander et al.'s "Fast
+    // Triangle Reordering for Vertex Locality and Reduced Overdraw"
+    void optimizeOverdraw(std::vector<unsigned int> &indices,
+                          std::vector<Vertex> const &vertices,
+                          float const threshold = OVERDRAW_THRESHOLD);
+
+    // Renumbers the vertices in order of first use
+    void optimizeVertexFetch(std::vector<Vertex> &vertices,
+                             std::vector<unsigned int> &indices);
+
+    // Quadric error edge collapse (Garland and Heckbert) onto existing
+    // vertices, so the result indexes the same vertex buffer. Vertices on
+    // borders and attribute seams stay in place, which keeps the mesh
+    // closed; returns fewer triangles than asked for when it runs out of
+    // collapses that don't flip a triangle.
+    std::vector<unsigned int> simplify(std::vector<Vertex> const &vertices,
+                                       std::vector<unsigned int> const &indices,
+                                       std::size_t const targetIndexCount);
+
+    // Appends up to LOD_COUNT - 1 simplified, cache-ordered index sets to
+    // the full mesh's indices; returns where each level starts, with the
+    // end of the buffer last
+    std::vector<unsigned int> generateLods(
+            std::vector<Vertex> const &vertices,
+            std::vector<unsigned int> &indices);
+
+    // Average cache miss ratio: vertices transformed per triangle
+    float acmr(std::vector<unsigned int> const &indices,
+               std::size_t const vertexCount,
+               int const cacheSize = CACHE_SIZE);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // MESH_OPTIMIZER_H
@@ -1,76 +1,176 @@
 // //////////////////////////////////////////////////////////// Includes //
 #include "mesh.hpp"
+#include "environment-lighting.hpp"
+#include "material-table.hpp"
 
 #include "opengl-headers.hpp"
+#include "frame-stats.hpp"
+
+#include "glm/gtc/packing.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 
 // ////////////////////////////////////////////////////////////// Usings //
 using std::vector;
 using std::shared_ptr;
 
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    // Maps the unit sphere onto the [-1, 1] square: project onto the
+    // octahedron |x| + |y| + |z| = 1 and fold its lower half outwards
+    glm::vec2 encodeOctahedral(glm::vec3 n) {
+        float const sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (sum == 0.0f) {
+            return glm::vec2(0.0f);
+        }
+        n /= sum;
+        if (n.z >= 0.0f) {
+            return glm::vec2(n.x, n.y);
+        }
+        glm::vec2 const sign(n.x >= 0.0f ? 1.0f : -1.0f,
+                             n.y >= 0.0f ? 1.0f : -1.0f);
+        return (glm::vec2(1.0f) - glm::abs(glm::vec2(n.y, n.x))) * sign;
+    }
+
+    std::int16_t snorm16(float const value) {
+        return static_cast<std::int16_t>(
+                std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    std::uint16_t unorm16(float const value) {
+        return static_cast<std::uint16_t>(
+                std::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+    }
+}
+
 // ///////////////////////////////////////////////////////////////////// // 
+bool Mesh::quantizeVertices = false;
+
 Mesh::Mesh(vector<Vertex> const &vertices,
            vector<unsigned int> const &indices,
-           vector<Texture> const &textures)
-        : vertices(vertices),
+           int const material,
+           vector<unsigned int> const &lodOffsets)
+        : quantized(false),
+          vertices(vertices),
           indices(indices),
-          textures(textures) {
+          lodOffsets(lodOffsets),
+          material(material) {
+    if (this->lodOffsets.size() < 2) {
+        this->lodOffsets = {0, static_cast<unsigned int>(indices.size())};
+    }
+    calculateBounds();
 }
 
-void Mesh::render(shared_ptr<Shader> shader) const {
+int Mesh::lodCount() const {
+    return static_cast<int>(lodOffsets.size()) - 1;
+}
+
+void Mesh::render(shared_ptr<Shader> shader, int const lod,
+                  int const instances, int const firstDraw) const {
     shader->use();
-    shader->uniform1i("texAo", 0);
-    shader->uniform1i("texAlbedo", 1);
-    shader->uniform1i("texMetalness", 2);
-    shader->uniform1i("texRoughness", 3);
-    shader->uniform1i("texNormal", 4);
+    shader->uniform1i("texAlbedo", MaterialTable::ALBEDO_UNIT);
+    shader->uniform1i("texOrm", MaterialTable::ORM_UNIT);
+    shader->uniform1i("texNormal", MaterialTable::NORMAL_UNIT);
     shader->uniform1i("texSkybox", 5);
     shader->uniform1i("texShadow", 6);
+    shader->uniform1i("texIrradiance",
+                      EnvironmentLighting::IRRADIANCE_UNIT);
+    shader->uniform1i("texPrefiltered",
+                      EnvironmentLighting::PREFILTERED_UNIT);
+    shader->uniform1i("texBrdfLut", EnvironmentLighting::BRDF_LUT_UNIT);
+    if (quantized) {
+        shader->uniform3f("positionOffset", boundingBox.min);
+        shader->uniform3f("positionScale",
+                          boundingBox.max - boundingBox.min);
+    }
 
-//    shader->uniform1i("instances", 1);
+    shader->uniform1i("firstDraw", firstDraw);
 
-    for (int i = 0; i < textures.size(); ++i) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
-    }
+    int const level = glm::clamp(lod, 0, lodCount() - 1);
+    unsigned int const first = lodOffsets[level];
 
-    glBindVertexArray(vao);
-//        glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr, 1);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+    vao.bind();
+    gl::drawElementsInstanced(GL_TRIANGLES,
+                              lodOffsets[level + 1] - first,
+                              GL_UNSIGNED_INT,
+                              (void *) (first * sizeof(unsigned int)),
+                              instances);
 }
 
 void Mesh::setupMesh() {
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
-
-    glBindVertexArray(vao); {
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    vao = gl::VertexArray::create();
+    quantized = quantizeVertices;
+    if (quantized) {
+        setupPackedMesh();
+        return;
+    }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    vbo = gl::Buffer(vertices.size() * sizeof(Vertex), vertices.data());
+    ebo = gl::Buffer(indices.size() * sizeof(unsigned int), indices.data());
 
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)nullptr);
+    vao.vertexBuffer(0, vbo, sizeof(Vertex));
+    vao.elementBuffer(ebo);
+    vao.attribute(0, 0, 3, GL_FLOAT, false, offsetof(Vertex, position));
+    vao.attribute(1, 0, 3, GL_FLOAT, false, offsetof(Vertex, normal));
+    vao.attribute(2, 0, 2, GL_FLOAT, false, offsetof(Vertex, texCoords));
+    vao.attribute(3, 0, 4, GL_FLOAT, false, offsetof(Vertex, tangent));
+}
 
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3)));
+void Mesh::setupPackedMesh() {
+    glm::vec3 const size = boundingBox.max - boundingBox.min;
+
+    vector<PackedVertex> packed(vertices.size());
+    for (int i = 0; i < vertices.size(); ++i) {
+        Vertex const &vertex = vertices[i];
+        PackedVertex &out = packed[i];
+
+        for (int axis = 0; axis < 3; ++axis) {
+            out.position[axis] = unorm16(
+                    size[axis] > 0.0f
+                    ? (vertex.position[axis] - boundingBox.min[axis]) /
+                      size[axis]
+                    : 0.0f);
+        }
+        out.position[3] = unorm16(vertex.tangent.w < 0.0f ? 0.0f : 1.0f);
+
+        glm::vec2 const normal = encodeOctahedral(vertex.normal);
+        glm::vec2 const tangent =
+                encodeOctahedral(glm::vec3(vertex.tangent));
+        for (int axis = 0; axis < 2; ++axis) {
+            out.normal[axis] = snorm16(normal[axis]);
+            out.tangent[axis] = snorm16(tangent[axis]);
+            out.texCoords[axis] = glm::packHalf1x16(vertex.texCoords[axis]);
+        }
+    }
 
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(2 * sizeof(glm::vec3)));
+    vbo = gl::Buffer(packed.size() * sizeof(PackedVertex), packed.data());
+    ebo = gl::Buffer(indices.size() * sizeof(unsigned int), indices.data());
+
+    vao.vertexBuffer(0, vbo, sizeof(PackedVertex));
+    vao.elementBuffer(ebo);
+    vao.attribute(0, 0, 4, GL_UNSIGNED_SHORT, true,
+                  offsetof(PackedVertex, position));
+    vao.attribute(1, 0, 2, GL_SHORT, true, offsetof(PackedVertex, normal));
+    vao.attribute(2, 0, 2, GL_HALF_FLOAT, false,
+                  offsetof(PackedVertex, texCoords));
+    vao.attribute(3, 0, 2, GL_SHORT, true, offsetof(PackedVertex, tangent));
+}
 
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(2 * sizeof(glm::vec3) + sizeof(glm::vec2)));
+void Mesh::calculateBounds() {
+    boundingBox = BoundingBox::empty();
+    for (auto const &vertex : vertices) {
+        boundingBox.extend(vertex.position);
     }
-}
 
-Mesh::~Mesh() {
-//    for (auto const &texture : textures) {
-//        glDeleteTextures(1, &texture.id);
-//    }
-//    glDeleteBuffers(1, &ebo);
-//    glDeleteBuffers(1, &vbo);
-//    glDeleteVertexArrays(1, &vao);
+    // Sphere around the box center, tight to the farthest vertex
+    boundingSphere = {boundingBox.center(), 0.0f};
+    for (auto const &vertex : vertices) {
+        boundingSphere.radius = glm::max(boundingSphere.radius,
+                                         glm::distance(boundingSphere.center,
+                                                       vertex.position));
+    }
 }
 
 // ///////////////////////////////////////////////////////////////////// // 
@@ -2,9 +2,12 @@
 #define MESH_H
 // //////////////////////////////////////////////////////////// Includes //
 #include "shader.hpp"
+#include "bounding-volume.hpp"
+#include "gl-resources.hpp"
 
 #include "opengl-headers.hpp"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
@@ -14,34 +17,60 @@ struct Vertex {
     glm::vec3 position;
     glm::vec3 normal;
     glm::vec2 texCoords;
-    glm::vec3 tangent;
+    // w is the sign of the bitangent, see tangent-space.hpp
+    glm::vec4 tangent;
 };
 
-// ///////////////////////////////////////////////////// Struct: Texture //
-struct Texture {
-    GLuint id;
-    std::string filename;
+// //////////////////////////////////////////////// Struct: PackedVertex //
+// 20 bytes instead of 48: the position quantized to 16 bits within the
+// mesh's bounding box, normal and tangent octahedral-encoded into two
+// signed normalized 16-bit values each, texture coordinates as half
+// floats. The fourth position component holds the sign of the bitangent,
+// 0 for negative and 1 for positive.
+// model/vertex.glsl dequantizes it with QUANTIZED_VERTICES defined.
+struct PackedVertex {
+    std::uint16_t position[4];
+    std::int16_t normal[2];
+    std::int16_t tangent[2];
+    std::uint16_t texCoords[2];
 };
 
 // ///////////////////////////////////////////////////////// Class: Mesh //
 class Mesh {
 public:
+    // Layout of the vertex buffers created by setupMesh()
+    static bool quantizeVertices;
 
+    // indices may hold several levels of detail back to back, starting
+    // at lodOffsets and followed by its end; without offsets all of them
+    // form one level. material indexes the MaterialTable.
     Mesh(std::vector<Vertex> const &vertices,
          std::vector<unsigned int> const &indices,
-         std::vector<Texture> const &textures);
+         int const material,
+         std::vector<unsigned int> const &lodOffsets = {});
 
-    ~Mesh();
+    // Instances read their DrawParameters from firstDraw onwards; levels
+    // past the last one draw the last one
+    void render(std::shared_ptr<Shader> shader, int const lod,
+                int const instances, int const firstDraw) const;
 
-    void render(std::shared_ptr<Shader> shader) const;
+    int lodCount() const;
 
 public:
     void setupMesh();
+    void setupPackedMesh();
+    void calculateBounds();
 
-    unsigned int vao, vbo, ebo;
+    gl::VertexArray vao;
+    gl::Buffer vbo, ebo;
+    bool quantized;
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
+    std::vector<unsigned int> lodOffsets;
+    int material;
+
+    BoundingBox boundingBox;
+    BoundingSphere boundingSphere;
 };
 // ///////////////////////////////////////////////////////////////////// //
 #endif // MESH_H
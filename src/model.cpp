@@ -1,5 +1,8 @@
 // //////////////////////////////////////////////////////////// Includes //
 #include "model.hpp"
+#include "cache.hpp"
+#include "mesh-optimizer.hpp"
+#include "tangent-space.hpp"
 
 #include <glad/glad.h>
 
@@ -10,34 +13,155 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-#include <exception>
-#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 
 // ////////////////////////////////////////////////////////////// Usings //
-using std::exception;
+using std::cout;
+using std::runtime_error;
+using std::shared_ptr;
 using std::string;
 using std::vector;
-using std::shared_ptr;
 
 using glm::vec2;
 using glm::vec3;
 
-// ///////////////////////////////////////////////////////////////////// //
-GLuint loadTextureFromFile(string const &filename);
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    struct CacheHeader {
+        std::uint32_t magic;
+        std::uint32_t vertexSize;
+        std::uint32_t meshCount;
+    };
+
+    struct CacheMeshHeader {
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+        std::uint32_t lodOffsetCount;
+        std::uint32_t directoryLength;
+    };
+
+    // Bump the last byte whenever the import or the optimizer changes
+    std::uint32_t const CACHE_MAGIC = 0x4c444d03u;
+
+    // Material libraries an .obj names on its mtllib lines, relative to
+    // the .obj's directory
+    vector<string> materialLibraries(string const &path,
+                                     vector<char> const &data) {
+        string const directory = path.substr(0, path.find_last_of('/') + 1);
+        string const keyword = "mtllib";
+
+        vector<string> libraries;
+        std::istringstream lines(string(data.begin(), data.end()));
+        for (string line; std::getline(lines, line);) {
+            if (line.compare(0, keyword.size(), keyword) != 0) {
+                continue;
+            }
+            std::size_t const first =
+                    line.find_first_not_of(" \t", keyword.size());
+            std::size_t const last = line.find_last_not_of(" \t\r");
+            if (first != string::npos && first > keyword.size()) {
+                libraries.push_back(
+                        directory + line.substr(first, last - first + 1));
+            }
+        }
+        return libraries;
+    }
+
+    // Keyed by the model and its material libraries, which hold the
+    // texture directory kept in the entry
+    string cacheFile(string const &path) {
+        string const directory = cache::directory("models");
+        vector<char> data;
+        if (directory.empty() || !cache::read(path, data)) {
+            return string();
+        }
+        std::uint64_t key = cache::hash(data.data(), data.size());
+        key = cache::hash(&CACHE_MAGIC, sizeof(CACHE_MAGIC), key);
+
+        vector<char> library;
+        for (string const &filename : materialLibraries(path, data)) {
+            if (!cache::read(filename, library)) {
+                return string();
+            }
+            key = cache::hash(library.data(), library.size(), key);
+        }
+        return directory + "/" + cache::hex(key) + ".bin";
+    }
+
+    // Copies raw bytes out of the cache entry, false past its end
+    bool take(vector<char> const &data, std::size_t &offset,
+              void *destination, std::size_t const size) {
+        if (data.size() - offset < size) {
+            return false;
+        }
+        std::memcpy(destination, data.data() + offset, size);
+        offset += size;
+        return true;
+    }
+
+    void append(vector<char> &data, void const *source,
+                std::size_t const size) {
+        char const *bytes = static_cast<char const *>(source);
+        data.insert(data.end(), bytes, bytes + size);
+    }
+}
 
 // ///////////////////////////////////////////////////////////////////// //
+shared_ptr<MaterialTable> Model::materialTable;
+
 Model::Model(string const &path) {
     loadModel(path);
 }
 
-void Model::render(shared_ptr<Shader> shader0) const {
+void Model::render(shared_ptr<Shader> shader0, int const lod,
+                   int const instances, int const firstDraw) const {
+    for (std::size_t i = 0; i < meshes.size(); ++i) {
+        meshes[i].render(shader0, lod, instances,
+                         firstDraw + static_cast<int>(i) * instances);
+    }
+}
+
+vector<int> Model::materials() const {
+    vector<int> materials;
+    for (auto const &mesh : meshes) {
+        materials.push_back(mesh.material);
+    }
+    return materials;
+}
+
+int Model::lodCount() const {
+    int count = 1;
     for (auto const &mesh : meshes) {
-        mesh.render(shader0);
+        count = std::max(count, mesh.lodCount());
     }
+    return count;
 }
 
 void Model::loadModel(string const &path) {
+    vector<MeshData> data;
+
+    string const filename = cacheFile(path);
+    if (filename.empty() || !loadCache(filename, data)) {
+        data.clear();
+        importModel(path, data);
+        saveCache(filename, data);
+    }
+
+    for (auto const &mesh : data) {
+        meshes.push_back(createMesh(mesh));
+        meshes.back().setupMesh();
+    }
+    calculateBounds();
+}
+
+void Model::importModel(string const &path, vector<MeshData> &data) {
     Assimp::Importer importer;
 
     aiScene const *scene = importer.ReadFile(path,
@@ -46,33 +170,67 @@ void Model::loadModel(string const &path) {
     if (!scene ||
         scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
         !scene->mRootNode) {
-        throw exception((string("ERROR::ASSIMP:: ") +
+        throw runtime_error((string("ERROR::ASSIMP:: ") +
                          string(importer.GetErrorString())).c_str());
     }
 
-    processNode(scene->mRootNode, scene);
+    processNode(scene->mRootNode, scene, data);
+
+    for (auto &mesh : data) {
+        optimizer::Report const report =
+                optimizer::optimize(mesh.vertices, mesh.indices);
+        cout << path << ": " << report.verticesBefore << " -> "
+             << report.verticesAfter << " vertices, ACMR "
+             << report.acmrBefore << " -> " << report.acmrAfter;
+
+        mesh.lodOffsets = optimizer::generateLods(mesh.vertices,
+                                                  mesh.indices);
+        cout << ", LOD triangles";
+        for (std::size_t lod = 0; lod + 1 < mesh.lodOffsets.size();
+             ++lod) {
+            cout << " " << (mesh.lodOffsets[lod + 1] -
+                            mesh.lodOffsets[lod]) / 3;
+        }
+        cout << "\n";
+    }
+}
+
+void Model::calculateBounds() {
+    boundingBox = BoundingBox::empty();
+    for (auto const &mesh : meshes) {
+        boundingBox.extend(mesh.boundingBox);
+    }
+
+    boundingSphere = {boundingBox.center(), 0.0f};
+    for (auto const &mesh : meshes) {
+        boundingSphere.radius = glm::max(
+                boundingSphere.radius,
+                glm::distance(boundingSphere.center,
+                              mesh.boundingSphere.center) +
+                mesh.boundingSphere.radius);
+    }
 }
 
-void Model::processNode(aiNode *node, const aiScene *scene) {
+void Model::processNode(aiNode *node, const aiScene *scene,
+                        vector<MeshData> &data) {
     if (!node) {
         return;
     }
     for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
-        Mesh m = processMesh(scene->mMeshes[node->mMeshes[i]], scene);
+        MeshData m = processMesh(scene->mMeshes[node->mMeshes[i]], scene);
         if (m.vertices.size() > 0) {
-            m.setupMesh();
-            meshes.push_back(m);
+            data.push_back(std::move(m));
         }
     }
     for (unsigned int i = 0; i < node->mNumChildren; ++i) {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, data);
     }
 }
 
-Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
-    vector<Vertex> vertices;
-    vector<unsigned int> indices;
-    vector<Texture> textures;
+Model::MeshData Model::processMesh(aiMesh *mesh, const aiScene *scene) {
+    MeshData data;
+    vector<Vertex> &vertices = data.vertices;
+    vector<unsigned int> &indices = data.indices;
 
     for (int i = 0; i < mesh->mNumVertices; ++i) {
         Vertex vertex;
@@ -101,31 +259,6 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
         vertices.push_back(vertex);
     }
 
-    // Calculate tangent vectors
-    for (int i = 0; i < indices.size(); i += 3) {
-        Vertex &v0 = vertices[indices[i]];
-        Vertex &v1 = vertices[indices[i + 1]];
-        Vertex &v2 = vertices[indices[i + 2]];
-
-        vec3 edge1 = v1.position - v0.position;
-        vec3 edge2 = v2.position - v0.position;
-
-        vec2 delta1 = v1.texCoords - v0.texCoords;
-        vec2 delta2 = v2.texCoords - v0.texCoords;
-
-        vec3 tangent = ((delta2.y * edge1 - delta1.y * edge2)
-                        / (delta1.x * delta2.y - delta2.x * delta1.y));
-
-        v0.tangent += tangent;
-        v1.tangent += tangent;
-        v2.tangent += tangent;
-    }
-    for (auto & vertex : vertices) {
-        vertex.tangent /= vertex.tangent.length();
-    }
-
-    //---------------------------
-
     for (int i = 0; i < mesh->mNumFaces; ++i) {
         aiFace face = mesh->mFaces[i];
 
@@ -133,29 +266,93 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
             indices.push_back(face.mIndices[j]);
     }
 
+    tangents::generate(vertices, indices);
+
     aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
 
     aiString dirPath;
     material->GetTexture(aiTextureType_AMBIENT, 0, &dirPath);
-    textures.push_back(
-            {loadTextureFromFile(string(dirPath.C_Str()) + "\\ao.jpg"),
-                    string(dirPath.C_Str()) + "\\ao.jpg"});
-    textures.push_back(
-            {loadTextureFromFile(string(dirPath.C_Str()) + "\\albedo.jpg"),
-                    string(dirPath.C_Str()) + "\\albedo.jpg"});
-    textures.push_back({loadTextureFromFile(
-            string(dirPath.C_Str()) + "\\metalness.jpg"),
-                               string(dirPath.C_Str()) +
-                               "\\metalness.jpg"});
-    textures.push_back({loadTextureFromFile(
-            string(dirPath.C_Str()) + "\\roughness.jpg"),
-                               string(dirPath.C_Str()) +
-                               "\\roughness.jpg"});
-    textures.push_back(
-            {loadTextureFromFile(string(dirPath.C_Str()) + "\\normal.jpg"),
-                    string(dirPath.C_Str()) + "\\normal.jpg"});
-
-    return Mesh(vertices, indices, textures);
+
+    // Material paths are written with Windows separators
+    data.textureDirectory = dirPath.C_Str();
+    std::replace(data.textureDirectory.begin(), data.textureDirectory.end(),
+                 '\\', '/');
+
+    return data;
+}
+
+Mesh Model::createMesh(MeshData const &data) {
+    return Mesh(data.vertices, data.indices,
+                materialTable->add(data.textureDirectory), data.lodOffsets);
+}
+
+bool Model::loadCache(string const &filename, vector<MeshData> &data) {
+    vector<char> bytes;
+    if (!cache::read(filename, bytes)) {
+        return false;
+    }
+
+    std::size_t offset = 0;
+    CacheHeader header;
+    if (!take(bytes, offset, &header, sizeof(header)) ||
+        header.magic != CACHE_MAGIC ||
+        header.vertexSize != sizeof(Vertex)) {
+        return false;
+    }
+
+    data.resize(header.meshCount);
+    for (auto &mesh : data) {
+        CacheMeshHeader meshHeader;
+        if (!take(bytes, offset, &meshHeader, sizeof(meshHeader))) {
+            return false;
+        }
+        mesh.textureDirectory.resize(meshHeader.directoryLength);
+        mesh.vertices.resize(meshHeader.vertexCount);
+        mesh.indices.resize(meshHeader.indexCount);
+        mesh.lodOffsets.resize(meshHeader.lodOffsetCount);
+        if (!take(bytes, offset, &mesh.textureDirectory[0],
+                  mesh.textureDirectory.size()) ||
+            !take(bytes, offset, mesh.vertices.data(),
+                  mesh.vertices.size() * sizeof(Vertex)) ||
+            !take(bytes, offset, mesh.indices.data(),
+                  mesh.indices.size() * sizeof(unsigned int)) ||
+            !take(bytes, offset, mesh.lodOffsets.data(),
+                  mesh.lodOffsets.size() * sizeof(unsigned int))) {
+            return false;
+        }
+    }
+    return offset == bytes.size();
+}
+
+void Model::saveCache(string const &filename, vector<MeshData> const &data) {
+    if (filename.empty()) {
+        return;
+    }
+
+    vector<char> bytes;
+    CacheHeader const header = {
+            CACHE_MAGIC, sizeof(Vertex),
+            static_cast<std::uint32_t>(data.size())};
+    append(bytes, &header, sizeof(header));
+
+    for (auto const &mesh : data) {
+        CacheMeshHeader const meshHeader = {
+                static_cast<std::uint32_t>(mesh.vertices.size()),
+                static_cast<std::uint32_t>(mesh.indices.size()),
+                static_cast<std::uint32_t>(mesh.lodOffsets.size()),
+                static_cast<std::uint32_t>(mesh.textureDirectory.size())};
+        append(bytes, &meshHeader, sizeof(meshHeader));
+        append(bytes, mesh.textureDirectory.data(),
+               mesh.textureDirectory.size());
+        append(bytes, mesh.vertices.data(),
+               mesh.vertices.size() * sizeof(Vertex));
+        append(bytes, mesh.indices.data(),
+               mesh.indices.size() * sizeof(unsigned int));
+        append(bytes, mesh.lodOffsets.data(),
+               mesh.lodOffsets.size() * sizeof(unsigned int));
+    }
+
+    cache::write(filename, bytes);
 }
 
 // ///////////////////////////////////////////////////////////////////// //
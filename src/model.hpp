@@ -4,6 +4,7 @@
 #include "shader.hpp"
 #include "mesh.hpp"
 #include "renderable.hpp"
+#include "material-table.hpp"
 
 #include "assimp/scene.h"
 
@@ -12,19 +13,47 @@
 #include <memory>
 
 // //////////////////////////////////////////////////////// Class: Model //
+// Imported meshes go through the mesh optimizer once, which also builds
+// their levels of detail; the result is cached on disk, keyed by the
+// model file.
 class Model : public Renderable {
 private:
+    // Geometry as imported and optimized, before it is uploaded
+    struct MeshData {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<unsigned int> lodOffsets;
+        std::string textureDirectory;
+    };
+
     std::vector<Mesh> meshes;
 
 public:
+    // Materials of every model, set up before the first one is loaded
+    static std::shared_ptr<MaterialTable> materialTable;
+
     Model(std::string const &path);
 
-    void render(std::shared_ptr<Shader> shader) const;
-    
+    void render(std::shared_ptr<Shader> shader, int const lod = 0,
+                int const instances = 1, int const firstDraw = 0) const;
+    int lodCount() const;
+    std::vector<int> materials() const;
+
+    BoundingSphere boundingSphere;
+
 private:
     void loadModel(std::string const &path);
-    void processNode(aiNode *node, const aiScene *scene);
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene);
+    void importModel(std::string const &path, std::vector<MeshData> &data);
+    void processNode(aiNode *node, const aiScene *scene,
+                     std::vector<MeshData> &data);
+    MeshData processMesh(aiMesh *mesh, const aiScene *scene);
+    Mesh createMesh(MeshData const &data);
+    void calculateBounds();
+
+    static bool loadCache(std::string const &filename,
+                          std::vector<MeshData> &data);
+    static void saveCache(std::string const &filename,
+                          std::vector<MeshData> const &data);
 };
 
 // ///////////////////////////////////////////////////////////////////// //
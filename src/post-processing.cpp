@@ -0,0 +1,318 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "post-processing.hpp"
+#include "frame-stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::make_shared;
+using std::shared_ptr;
+using std::vector;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    int scaled(int const size, float const scale) {
+        return std::max(1, static_cast<int>(std::lround(size * scale)));
+    }
+
+    // Radical inverse of the index in the given base, in [0, 1)
+    float halton(int index, int const base) {
+        float result = 0.0f;
+        float fraction = 1.0f;
+        while (index > 0) {
+            fraction /= base;
+            result += fraction * (index % base);
+            index /= base;
+        }
+        return result;
+    }
+
+    gl::Texture createColorTexture(int const width, int const height,
+                                   GLenum const format = GL_RGBA16F,
+                                   GLint const filter = GL_LINEAR) {
+        gl::Texture texture(GL_TEXTURE_2D, 1, format, width, height, 1,
+                            resources::CATEGORY_TARGETS);
+        texture.parameter(GL_TEXTURE_MIN_FILTER, filter);
+        texture.parameter(GL_TEXTURE_MAG_FILTER, filter);
+        texture.parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        texture.parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+
+    gl::Framebuffer createFramebuffer(gl::Texture const &texture) {
+        gl::Framebuffer framebuffer = gl::Framebuffer::create();
+        framebuffer.attach(GL_COLOR_ATTACHMENT0, texture);
+        framebuffer.check();
+        return framebuffer;
+    }
+}
+
+// /////////////////////////////////////////////// Class: PostProcessing //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+PostProcessing::PostProcessing(int const msaaSamples)
+        : antialiasing(AA_MSAA),
+          bloom(true), bloomThreshold(1.0f), bloomStrength(0.05f),
+          exposure(1.0f),
+          msaaSamples(msaaSamples),
+          taaShader(make_shared<Shader>(
+                  "res/shaders/post/fullscreen.glsl",
+                  "res/shaders/post/taa.glsl")),
+          brightShader(make_shared<Shader>(
+                  "res/shaders/post/fullscreen.glsl",
+                  "res/shaders/post/bright.glsl")),
+          blurShader(make_shared<Shader>(
+                  "res/shaders/post/fullscreen.glsl",
+                  "res/shaders/post/blur.glsl")),
+          tonemapShader(make_shared<Shader>(
+                  "res/shaders/post/fullscreen.glsl",
+                  "res/shaders/post/tonemap.glsl")),
+          windowWidth(0), windowHeight(0),
+          targetWidth(0), targetHeight(0),
+          sceneWidth(0), sceneHeight(0), samples(0), velocity(false),
+          frame(0), history(0), historyValid(false),
+          historyScaleX(1.0f), historyScaleY(1.0f) {
+    // Fullscreen passes generate their triangle from gl_VertexID
+    emptyVao = gl::VertexArray::create();
+}
+
+void PostProcessing::resize(int const windowWidth, int const windowHeight,
+                            float const renderScale,
+                            float const maxRenderScale) {
+    int const width = scaled(windowWidth, maxRenderScale);
+    int const height = scaled(windowHeight, maxRenderScale);
+    int const wantedSamples = antialiasing == AA_MSAA ? msaaSamples : 0;
+    bool const wantedVelocity = antialiasing == AA_TAA;
+
+    this->windowWidth = windowWidth;
+    this->windowHeight = windowHeight;
+    if (width != targetWidth || height != targetHeight ||
+        wantedSamples != samples || wantedVelocity != velocity) {
+        targetWidth = width;
+        targetHeight = height;
+        samples = wantedSamples;
+        velocity = wantedVelocity;
+        createTargets();
+        historyValid = false;
+    }
+
+    sceneWidth = std::min(scaled(windowWidth, renderScale), targetWidth);
+    sceneHeight = std::min(scaled(windowHeight, renderScale), targetHeight);
+}
+
+glm::vec2 PostProcessing::jitter() const {
+    if (antialiasing != AA_TAA) {
+        return glm::vec2(0.0f);
+    }
+
+    // Skip index 0, which is the pixel's corner in both bases
+    int const index = frame % JITTER_PHASES + 1;
+    return glm::vec2((halton(index, 2) - 0.5f) * 2.0f / sceneWidth,
+                     (halton(index, 3) - 0.5f) * 2.0f / sceneHeight);
+}
+
+void PostProcessing::begin() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO.id());
+    glViewport(0, 0, sceneWidth, sceneHeight);
+}
+
+void PostProcessing::end(GLuint const outputFramebuffer) {
+    // ''''''''''''''''''''''''''''''''''''''''''''''''''''' Resolve samples
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO.id());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO.id());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glBlitFramebuffer(0, 0, sceneWidth, sceneHeight,
+                      0, 0, sceneWidth, sceneHeight,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    if (antialiasing == AA_TAA) {
+        glReadBuffer(GL_COLOR_ATTACHMENT1);
+        glDrawBuffer(GL_COLOR_ATTACHMENT1);
+        glBlitFramebuffer(0, 0, sceneWidth, sceneHeight,
+                          0, 0, sceneWidth, sceneHeight,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    emptyVao.bind();
+
+    // Used parts of the targets, in texture coordinates
+    float const sceneScaleX = static_cast<float>(sceneWidth) / targetWidth;
+    float const sceneScaleY = static_cast<float>(sceneHeight) / targetHeight;
+
+    int const bloomWidth = std::max(sceneWidth / 2, 1);
+    int const bloomHeight = std::max(sceneHeight / 2, 1);
+    float const bloomScaleX = static_cast<float>(bloomWidth) /
+                              std::max(targetWidth / 2, 1);
+    float const bloomScaleY = static_cast<float>(bloomHeight) /
+                              std::max(targetHeight / 2, 1);
+
+    // ''''''''''''''''''''''''''''''''''''''''''''''''''''''''''''''''' TAA
+    GLuint scene = resolveTexture.id();
+    if (antialiasing == AA_TAA) {
+        scene = resolveTemporal(sceneScaleX, sceneScaleY);
+    } else {
+        historyValid = false;
+    }
+    frame++;
+
+    // '''''''''''''''''''''''''''''''''''''''''''''''''''''''''''''''' Bloom
+    if (bloom) {
+        glViewport(0, 0, bloomWidth, bloomHeight);
+
+        // Bright parts, downsampled to half resolution
+        glBindFramebuffer(GL_FRAMEBUFFER, bloomFBO[0].id());
+        brightShader->use();
+        brightShader->uniform1i("texScene", 0);
+        brightShader->uniform2f("texCoordScale", sceneScaleX, sceneScaleY);
+        brightShader->uniform1f("threshold", bloomThreshold);
+        glActiveTexture(GL_TEXTURE0);
+        gl::bindTexture(GL_TEXTURE_2D, scene);
+        drawFullscreen();
+
+        // Separable Gaussian, ping-ponging between the two targets
+        blurShader->use();
+        blurShader->uniform1i("texSource", 0);
+        blurShader->uniform2f("texCoordScale", bloomScaleX, bloomScaleY);
+        for (int pass = 0; pass < 2 * BLUR_PASSES; ++pass) {
+            int const target = (pass + 1) % 2;
+            bool const horizontal = pass % 2 == 0;
+            glBindFramebuffer(GL_FRAMEBUFFER, bloomFBO[target].id());
+            blurShader->uniform2f("texelStep",
+                                  horizontal ? 1.0f / bloomWidth : 0.0f,
+                                  horizontal ? 0.0f : 1.0f / bloomHeight);
+            gl::bindTexture(GL_TEXTURE_2D, bloomTexture[1 - target].id());
+            drawFullscreen();
+        }
+    }
+
+    // '''''''''''''''''''''''''''''''''''''''''''''''''''''''''''' Tonemap
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    glViewport(0, 0, windowWidth, windowHeight);
+
+    tonemapShader->use();
+    tonemapShader->uniform1i("texScene", 0);
+    tonemapShader->uniform1i("texBloom", 1);
+    tonemapShader->uniform2f("sceneTexCoordScale", sceneScaleX, sceneScaleY);
+    tonemapShader->uniform2f("bloomTexCoordScale", bloomScaleX, bloomScaleY);
+    tonemapShader->uniform1f("exposure", exposure);
+    tonemapShader->uniform1f("bloomStrength", bloom ? bloomStrength : 0.0f);
+    glActiveTexture(GL_TEXTURE0);
+    gl::bindTexture(GL_TEXTURE_2D, scene);
+    glActiveTexture(GL_TEXTURE1);
+    gl::bindTexture(GL_TEXTURE_2D, bloomTexture[0].id());
+    drawFullscreen();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(0);
+}
+
+int PostProcessing::width() const {
+    return sceneWidth;
+}
+
+int PostProcessing::height() const {
+    return sceneHeight;
+}
+
+vector<shared_ptr<Shader>> PostProcessing::shaders() const {
+    return {taaShader, brightShader, blurShader, tonemapShader};
+}
+
+// ============================================== Private implementation ==
+// ----------------------------------------------------------- Behaviour --
+void PostProcessing::createTargets() {
+    // Assigning releases the previous targets, which frames already
+    // submitted may still read; the resource manager deletes them once
+    // the GPU is done with those frames
+
+    // Scene target, multisampled in MSAA mode
+    sceneColor = gl::Renderbuffer(GL_RGBA16F, targetWidth, targetHeight,
+                                  samples);
+
+    // Velocities only for TAA, the other modes would just write them
+    sceneVelocity = velocity
+                    ? gl::Renderbuffer(GL_RG16F, targetWidth, targetHeight,
+                                       samples)
+                    : gl::Renderbuffer();
+
+    sceneDepth = gl::Renderbuffer(GL_DEPTH24_STENCIL8, targetWidth,
+                                  targetHeight, samples);
+
+    sceneFBO = gl::Framebuffer::create();
+    sceneFBO.attach(GL_COLOR_ATTACHMENT0, sceneColor);
+    sceneFBO.attach(GL_DEPTH_STENCIL_ATTACHMENT, sceneDepth);
+    if (velocity) {
+        sceneFBO.attach(GL_COLOR_ATTACHMENT1, sceneVelocity);
+        sceneFBO.drawBuffers({GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1});
+    } else {
+        sceneFBO.drawBuffers({GL_COLOR_ATTACHMENT0});
+    }
+    sceneFBO.check();
+
+    // Resolved scene, sampled by the post-processing passes
+    resolveTexture = createColorTexture(targetWidth, targetHeight);
+    resolveFBO = createFramebuffer(resolveTexture);
+
+    // Second attachment of the resolve framebuffer
+    velocityTexture = gl::Texture();
+    if (velocity) {
+        velocityTexture = createColorTexture(targetWidth, targetHeight,
+                                             GL_RG16F, GL_NEAREST);
+        resolveFBO.attach(GL_COLOR_ATTACHMENT1, velocityTexture);
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        historyTexture[i] = createColorTexture(targetWidth, targetHeight);
+        historyFBO[i] = createFramebuffer(historyTexture[i]);
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        bloomTexture[i] = createColorTexture(std::max(targetWidth / 2, 1),
+                                             std::max(targetHeight / 2, 1));
+        bloomFBO[i] = createFramebuffer(bloomTexture[i]);
+    }
+}
+
+GLuint PostProcessing::resolveTemporal(float const scaleX,
+                                       float const scaleY) {
+    int const target = 1 - history;
+    glViewport(0, 0, sceneWidth, sceneHeight);
+    glBindFramebuffer(GL_FRAMEBUFFER, historyFBO[target].id());
+
+    taaShader->use();
+    taaShader->uniform1i("texScene", 0);
+    taaShader->uniform1i("texVelocity", 1);
+    taaShader->uniform1i("texHistory", 2);
+    taaShader->uniform2f("texCoordScale", scaleX, scaleY);
+    taaShader->uniform2f("historyTexCoordScale",
+                         historyScaleX, historyScaleY);
+    taaShader->uniform1f("historyWeight",
+                         historyValid ? HISTORY_WEIGHT : 0.0f);
+    glActiveTexture(GL_TEXTURE0);
+    gl::bindTexture(GL_TEXTURE_2D, resolveTexture.id());
+    glActiveTexture(GL_TEXTURE1);
+    gl::bindTexture(GL_TEXTURE_2D, velocityTexture.id());
+    glActiveTexture(GL_TEXTURE2);
+    gl::bindTexture(GL_TEXTURE_2D, historyTexture[history].id());
+    drawFullscreen();
+    glActiveTexture(GL_TEXTURE0);
+
+    // The render scale may differ next frame, remember this one's
+    history = target;
+    historyValid = true;
+    historyScaleX = scaleX;
+    historyScaleY = scaleY;
+    return historyTexture[target].id();
+}
+
+void PostProcessing::drawFullscreen() const {
+    gl::drawArrays(GL_TRIANGLES, 0, 3);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,122 @@
+#ifndef POST_PROCESSING_H
+#define POST_PROCESSING_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "gl-resources.hpp"
+#include "opengl-headers.hpp"
+#include "shader.hpp"
+
+#include "glm/glm.hpp"
+
+#include <memory>
+#include <vector>
+
+// ////////////////////////////////////////////////// Enum: Antialiasing //
+enum Antialiasing {
+    AA_OFF,
+    AA_MSAA,
+    AA_TAA
+};
+
+// /////////////////////////////////////////////// Class: PostProcessing //
+// The 3D scene is drawn into an RGBA16F target at a scaled internal
+// resolution, together with per-pixel velocities when TAA needs them.
+// end() resolves it, optionally adds bloom, and tonemaps it into the
+// output framebuffer at the window's resolution, where the HUD is drawn
+// afterwards. Targets are allocated for the largest scale and a frame
+// renders into their lower-left corner, so the scale can change every
+// frame without reallocating anything. Replaced targets go through the
+// resource manager, which keeps them until frames in flight are done.
+//
+// Anti-aliasing either multisamples the scene target, or jitters the
+// projection by a sub-pixel offset every frame and accumulates the
+// frames in a history buffer (TAA). The history is reprojected with the
+// velocities and clamped to the current neighbourhood's colours, which
+// rejects what became disoccluded or changed.
+class PostProcessing {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    static constexpr int BLUR_PASSES = 3;
+
+    // Length of the Halton (2, 3) jitter sequence
+    static constexpr int JITTER_PHASES = 8;
+
+    // Share of the history in each TAA frame
+    static constexpr float HISTORY_WEIGHT = 0.9f;
+
+    // ------------------------------------------------------- Behaviour --
+    explicit PostProcessing(int const msaaSamples);
+
+    PostProcessing(PostProcessing const &) = delete;
+    PostProcessing &operator=(PostProcessing const &) = delete;
+
+    // Recreates the targets when the window, the largest scale or the
+    // anti-aliasing mode changed
+    void resize(int const windowWidth, int const windowHeight,
+                float const renderScale, float const maxRenderScale);
+
+    // Sub-pixel offset of this frame's projection, in normalized device
+    // coordinates; zero unless TAA is on
+    glm::vec2 jitter() const;
+
+    // Binds the HDR target and sets the viewport to the scaled size
+    void begin() const;
+
+    // Leaves the output framebuffer bound with a window-sized viewport,
+    // depth testing off
+    void end(GLuint const outputFramebuffer);
+
+    // Internal resolution of the scene
+    int width() const;
+    int height() const;
+
+    std::vector<std::shared_ptr<Shader>> shaders() const;
+
+    // ------------------------------------------------------------ Data --
+    Antialiasing antialiasing;
+    bool bloom;
+    float bloomThreshold, bloomStrength;
+    float exposure;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------- Behaviour --
+    void createTargets();
+
+    // Accumulates the resolved scene into the history, returns the
+    // texture holding the result
+    GLuint resolveTemporal(float const scaleX, float const scaleY);
+
+    void drawFullscreen() const;
+
+    // ------------------------------------------------------------ Data --
+    int const msaaSamples;
+    std::shared_ptr<Shader> taaShader, brightShader, blurShader,
+            tonemapShader;
+    gl::VertexArray emptyVao;
+
+    int windowWidth, windowHeight;
+    int targetWidth, targetHeight;
+    int sceneWidth, sceneHeight;
+    int samples;
+
+    // Whether the targets have velocity attachments, which only TAA reads
+    bool velocity;
+
+    gl::Framebuffer sceneFBO;
+    gl::Renderbuffer sceneColor, sceneVelocity, sceneDepth;
+    gl::Framebuffer resolveFBO;
+    gl::Texture resolveTexture, velocityTexture;
+    gl::Framebuffer historyFBO[2];
+    gl::Texture historyTexture[2];
+    gl::Framebuffer bloomFBO[2];
+    gl::Texture bloomTexture[2];
+
+    // TAA state: frame counter for the jitter, the history written last
+    // and the part of it that holds the image
+    unsigned frame;
+    int history;
+    bool historyValid;
+    float historyScaleX, historyScaleY;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // POST_PROCESSING_H
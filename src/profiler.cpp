@@ -0,0 +1,262 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::ofstream;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    string escapeJson(string const &text) {
+        string escaped;
+        for (char const c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+}
+
+// ///////////////////////////////////////////////////// Class: Profiler //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+Profiler::Profiler()
+        : frame(0),
+          activeGpuScope(-1),
+          latestGpuFrameTime(-1.0f),
+          startTime(clock::now()) {
+}
+
+Profiler::~Profiler() {
+    if (!allQueries.empty()) {
+        glDeleteQueries(allQueries.size(), allQueries.data());
+    }
+}
+
+void Profiler::beginFrame() {
+    // Queries in this slot were issued FRAME_LATENCY frames ago
+    resolveQueries(frame % FRAME_LATENCY);
+
+    // Keep the trace bounded to the last HISTORY_SIZE frames
+    frameStarts.push_back(microsecondsSinceStart(clock::now()));
+    if (frameStarts.size() > HISTORY_SIZE) {
+        frameStarts.pop_front();
+    }
+    while (!trace.empty() && trace.front().timestamp < frameStarts.front()) {
+        trace.pop_front();
+    }
+
+    begin("Frame", false);
+}
+
+void Profiler::endFrame() {
+    end("Frame");
+    frame++;
+}
+
+void Profiler::begin(string const &name, bool const gpu) {
+    int const index = scopeIndex(name);
+
+    if (gpu && activeGpuScope < 0) {
+        GLuint const query = acquireQuery();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        pending[frame % FRAME_LATENCY].push_back(
+                {query, index, microsecondsSinceStart(clock::now())});
+        activeGpuScope = index;
+    }
+
+    scopes[index].start = clock::now();
+}
+
+void Profiler::end(string const &name) {
+    clock::time_point const endTime = clock::now();
+    int const index = scopeIndex(name);
+    Scope &scope = scopes[index];
+
+    double const start = microsecondsSinceStart(scope.start);
+    double const duration = microsecondsSinceStart(endTime) - start;
+
+    push(scope.cpuHistory, scope.cpuNext, duration / 1000.0);
+    trace.push_back({name, 1, start, duration});
+
+    if (activeGpuScope == index) {
+        glEndQuery(GL_TIME_ELAPSED);
+        activeGpuScope = -1;
+    }
+}
+
+void Profiler::recordSimulation(string const &name,
+                                clock::time_point const &start,
+                                clock::time_point const &end) {
+    int const index = scopeIndex(name);
+    Scope &scope = scopes[index];
+
+    double const startTime = microsecondsSinceStart(start);
+    double const duration = microsecondsSinceStart(end) - startTime;
+
+    push(scope.cpuHistory, scope.cpuNext, duration / 1000.0);
+    trace.push_back({name, 3, startTime, duration});
+}
+
+vector<string> const &Profiler::scopeNames() const {
+    return names;
+}
+
+Profiler::Statistics Profiler::cpuStatistics(string const &name) const {
+    auto const it = indices.find(name);
+    return it == indices.end()
+           ? Statistics{0.0f, 0.0f, 0.0f, 0.0f, 0.0f}
+           : calculateStatistics(scopes[it->second].cpuHistory);
+}
+
+Profiler::Statistics Profiler::gpuStatistics(string const &name) const {
+    auto const it = indices.find(name);
+    return it == indices.end()
+           ? Statistics{0.0f, 0.0f, 0.0f, 0.0f, 0.0f}
+           : calculateStatistics(scopes[it->second].gpuHistory);
+}
+
+float Profiler::latestCpu(string const &name) const {
+    auto const it = indices.find(name);
+    if (it == indices.end() || scopes[it->second].cpuHistory.empty()) {
+        return 0.0f;
+    }
+
+    Scope const &scope = scopes[it->second];
+    int const size = scope.cpuHistory.size();
+    return scope.cpuHistory[(scope.cpuNext + size - 1) % size];
+}
+
+float Profiler::latestGpuFrame() const {
+    return latestGpuFrameTime;
+}
+
+void Profiler::exportChromeTrace(string const &filename) const {
+    ofstream file(filename);
+    if (!file) {
+        throw runtime_error(("Couldn't write " + filename).c_str());
+    }
+
+    file << "{\"traceEvents\":[\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+            "\"args\":{\"name\":\"CPU\"}},\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,"
+            "\"args\":{\"name\":\"GPU\"}},\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,"
+            "\"args\":{\"name\":\"Simulation\"}}";
+
+    for (auto const &event : trace) {
+        file << ",\n{\"name\":\"" << escapeJson(event.name) << "\","
+             << "\"cat\":\"" << (event.thread == 2 ? "gpu" : "cpu") << "\","
+             << "\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ","
+             << "\"ts\":" << event.timestamp << ","
+             << "\"dur\":" << event.duration << "}";
+    }
+
+    file << "\n]}\n";
+}
+
+// ============================================== Private implementation ==
+// ----------------------------------------------------------- Behaviour --
+int Profiler::scopeIndex(string const &name) {
+    auto const it = indices.find(name);
+    if (it != indices.end()) {
+        return it->second;
+    }
+
+    names.push_back(name);
+    scopes.push_back({{}, {}, 0, 0, clock::now()});
+    indices[name] = scopes.size() - 1;
+    return scopes.size() - 1;
+}
+
+void Profiler::resolveQueries(int const slot) {
+    latestGpuFrameTime = -1.0f;
+
+    for (auto const &query : pending[slot]) {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(query.query, GL_QUERY_RESULT_AVAILABLE,
+                            &available);
+
+        // Drop samples that are still in flight instead of stalling
+        if (available) {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query.query, GL_QUERY_RESULT,
+                                  &nanoseconds);
+
+            Scope &scope = scopes[query.scope];
+            push(scope.gpuHistory, scope.gpuNext, nanoseconds / 1.0e6);
+            latestGpuFrameTime = glm::max(latestGpuFrameTime, 0.0f) +
+                                 nanoseconds / 1.0e6;
+            trace.push_back({names[query.scope], 2, query.timestamp,
+                             nanoseconds / 1.0e3});
+        }
+
+        freeQueries.push_back(query.query);
+    }
+    pending[slot].clear();
+}
+
+GLuint Profiler::acquireQuery() {
+    if (freeQueries.empty()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        allQueries.push_back(query);
+        return query;
+    }
+
+    GLuint const query = freeQueries.back();
+    freeQueries.pop_back();
+    return query;
+}
+
+double Profiler::microsecondsSinceStart(clock::time_point const &time) const {
+    return std::chrono::duration<double, std::micro>(time - startTime).count();
+}
+
+void Profiler::push(vector<float> &history, int &next, float const value) {
+    if (history.size() < HISTORY_SIZE) {
+        history.push_back(value);
+        return;
+    }
+    history[next] = value;
+    next = (next + 1) % HISTORY_SIZE;
+}
+
+Profiler::Statistics Profiler::calculateStatistics(vector<float> history) {
+    if (history.empty()) {
+        return {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    }
+
+    std::sort(history.begin(), history.end());
+
+    float sum = 0.0f;
+    for (float const value : history) {
+        sum += value;
+    }
+
+    auto const percentile = [&](float const p) -> float {
+        size_t const rank = static_cast<size_t>(p * (history.size() - 1)
+                                                + 0.5f);
+        return history[rank];
+    };
+
+    return {sum / history.size(),
+            percentile(0.50f),
+            percentile(0.95f),
+            percentile(0.99f),
+            history.back()};
+}
+
+// ///////////////////////////////////////////////////////////////////// //
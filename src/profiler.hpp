@@ -0,0 +1,128 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "opengl-headers.hpp"
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// ///////////////////////////////////////////////////// Class: Profiler //
+// CPU scopes are timed with the high-resolution clock, GPU scopes with
+// GL_TIME_ELAPSED queries. Queries are read back FRAME_LATENCY frames
+// after they were issued, so the CPU never waits for the GPU. GPU scopes
+// must not nest, because only one GL_TIME_ELAPSED query may be active.
+class Profiler {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    static constexpr int HISTORY_SIZE = 240;
+    static constexpr int FRAME_LATENCY = 2;
+
+    using clock = std::chrono::high_resolution_clock;
+
+    // ---------------------------------------------------------- Types --
+    struct Statistics {
+        float average, p50, p95, p99, max;
+    };
+
+    // ------------------------------------------------------- Behaviour --
+    Profiler();
+    ~Profiler();
+
+    void beginFrame();
+    void endFrame();
+
+    void begin(std::string const &name, bool gpu = true);
+    void end(std::string const &name);
+
+    // CPU scope timed on the simulation thread, which mustn't call into
+    // the profiler itself; traced on a track of its own
+    void recordSimulation(std::string const &name,
+                          clock::time_point const &start,
+                          clock::time_point const &end);
+
+    std::vector<std::string> const &scopeNames() const;
+
+    Statistics cpuStatistics(std::string const &name) const;
+    Statistics gpuStatistics(std::string const &name) const;
+
+    // Most recent CPU sample of a scope, in milliseconds
+    float latestCpu(std::string const &name) const;
+
+    // Sum of all GPU scopes of the most recently resolved frame, in
+    // milliseconds; negative if none of its queries were available
+    float latestGpuFrame() const;
+
+    // Writes the recorded history in Chrome's trace event format
+    // (load it in chrome://tracing or https://ui.perfetto.dev)
+    void exportChromeTrace(std::string const &filename) const;
+
+private: // ===================================== Private implementation ==
+    // ---------------------------------------------------------- Types --
+    struct Scope {
+        std::vector<float> cpuHistory, gpuHistory;
+        int cpuNext, gpuNext;
+        clock::time_point start;
+    };
+
+    struct PendingQuery {
+        GLuint query;
+        int scope;
+        double timestamp;
+    };
+
+    struct TraceEvent {
+        std::string name;
+        int thread;
+        double timestamp, duration;
+    };
+
+    // ------------------------------------------------------- Behaviour --
+    int scopeIndex(std::string const &name);
+    void resolveQueries(int const slot);
+    GLuint acquireQuery();
+    double microsecondsSinceStart(clock::time_point const &time) const;
+
+    static void push(std::vector<float> &history, int &next,
+                     float const value);
+    static Statistics calculateStatistics(std::vector<float> history);
+
+    // ------------------------------------------------------------ Data --
+    std::vector<std::string> names;
+    std::vector<Scope> scopes;
+    std::map<std::string, int> indices;
+
+    std::array<std::vector<PendingQuery>, FRAME_LATENCY> pending;
+    std::vector<GLuint> freeQueries, allQueries;
+    int frame;
+    int activeGpuScope;
+    float latestGpuFrameTime;
+
+    clock::time_point startTime;
+    std::deque<TraceEvent> trace;
+    std::deque<double> frameStarts;
+};
+
+// ////////////////////////////////////////////////// Class: ProfileScope //
+class ProfileScope {
+public:
+    ProfileScope(Profiler &profiler, std::string const &name,
+                 bool const gpu = true)
+            : profiler(profiler), name(name) {
+        profiler.begin(name, gpu);
+    }
+
+    ~ProfileScope() {
+        profiler.end(name);
+    }
+
+private:
+    Profiler &profiler;
+    std::string const name;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // PROFILER_H
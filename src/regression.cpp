@@ -0,0 +1,226 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "regression.hpp"
+
+#include "stb_image.h"
+
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::array;
+using std::cout;
+using std::ofstream;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    struct Lab {
+        float l, a, b;
+    };
+
+    float average(vector<float> const &values) {
+        if (values.empty()) {
+            return -1.0f;
+        }
+        float sum = 0.0f;
+        for (float const value : values) {
+            sum += value;
+        }
+        return sum / values.size();
+    }
+
+    // sRGB to linear, for every 8-bit value
+    array<float, 256> const &linearTable() {
+        static array<float, 256> const table = []() {
+            array<float, 256> table{};
+            for (int i = 0; i < 256; ++i) {
+                float const c = i / 255.0f;
+                table[i] = c <= 0.04045f
+                           ? c / 12.92f
+                           : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return table;
+        }();
+        return table;
+    }
+
+    float labCurve(float const t) {
+        return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+    }
+
+    // sRGB (D65) to CIE L*a*b*
+    Lab toLab(unsigned char const *rgb) {
+        array<float, 256> const &linear = linearTable();
+        float const r = linear[rgb[0]], g = linear[rgb[1]],
+                b = linear[rgb[2]];
+
+        float const x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.9505f;
+        float const y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+        float const z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.089f;
+
+        float const fx = labCurve(x), fy = labCurve(y), fz = labCurve(z);
+        return {116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz)};
+    }
+
+    void writePPM(string const &filename, int const width, int const height,
+                  vector<unsigned char> const &pixels) {
+        ofstream file(filename, std::ios::binary);
+        if (!file) {
+            throw runtime_error("Couldn't write " + filename);
+        }
+
+        file << "P6\n" << width << ' ' << height << "\n255\n";
+        file.write(reinterpret_cast<char const *>(pixels.data()),
+                   pixels.size());
+    }
+}
+
+// /////////////////////////////////////////////////// Class: Regression //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+Regression::Regression(RegressionSettings const &settings,
+                       vector<RegressionScene> const &scenes)
+        : settings(settings),
+          scenes(scenes),
+          sceneIndex(0),
+          frame(0) {
+}
+
+bool Regression::finished() const {
+    return sceneIndex >= scenes.size();
+}
+
+RegressionScene const &Regression::scene() const {
+    return scenes[sceneIndex];
+}
+
+bool Regression::capturing() const {
+    return frame == FRAMES_PER_SCENE - 1;
+}
+
+void Regression::advance() {
+    if (++frame < FRAMES_PER_SCENE) {
+        return;
+    }
+    frame = 0;
+    sceneIndex++;
+    cpuTimes.clear();
+    gpuTimes.clear();
+}
+
+void Regression::recordTiming(float const cpuTime, float const gpuTime) {
+    // The first frame of a scene still pays for switching to it
+    if (frame == 0) {
+        return;
+    }
+    cpuTimes.push_back(cpuTime);
+    if (gpuTime >= 0.0f) {
+        gpuTimes.push_back(gpuTime);
+    }
+}
+
+void Regression::recordFrame(vector<unsigned char> const &pixels) {
+    Result result = {scene().name, false, "", 0.0f, 0.0f, 0.0f,
+                     average(cpuTimes), average(gpuTimes)};
+
+    if (settings.update) {
+        // The first update creates the reference directory
+        std::filesystem::create_directories(settings.references);
+        writePPM(referencePath(), settings.width, settings.height, pixels);
+        result.passed = true;
+        result.note = "reference updated";
+        results.push_back(result);
+        return;
+    }
+
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(false);
+    unsigned char *reference = stbi_load(referencePath().c_str(),
+                                         &width, &height, &channels, 3);
+    if (reference == nullptr) {
+        result.note = "missing reference; record it with "
+                      "--regression-update";
+    } else if (width != settings.width || height != settings.height) {
+        result.note = "reference size differs";
+    } else {
+        size_t const count = static_cast<size_t>(width) * height;
+        size_t changed = 0;
+        double sum = 0.0;
+
+        for (size_t i = 0; i < count; ++i) {
+            Lab const p = toLab(&pixels[3 * i]);
+            Lab const q = toLab(&reference[3 * i]);
+            float const deltaE = std::sqrt((p.l - q.l) * (p.l - q.l) +
+                                           (p.a - q.a) * (p.a - q.a) +
+                                           (p.b - q.b) * (p.b - q.b));
+            sum += deltaE;
+            result.maxDeltaE = std::fmax(result.maxDeltaE, deltaE);
+            if (deltaE > settings.tolerance) {
+                changed++;
+            }
+        }
+
+        result.meanDeltaE = static_cast<float>(sum / count);
+        result.changedPixels = static_cast<float>(changed) / count;
+        result.passed = result.changedPixels <= settings.maxChangedPixels;
+    }
+    stbi_image_free(reference);
+
+    // Keep the failing frame next to the results for inspection
+    if (!result.passed) {
+        writePPM(settings.output + "." + result.scene + ".ppm",
+                 settings.width, settings.height, pixels);
+    }
+
+    cout << (result.passed ? "PASS " : "FAIL ") << result.scene
+         << " | mean dE " << result.meanDeltaE
+         << " | changed " << 100.0f * result.changedPixels << "%"
+         << (result.note.empty() ? "" : " | " + result.note) << '\n';
+    results.push_back(result);
+}
+
+void Regression::writeResults() const {
+    ofstream file(settings.output);
+    if (!file) {
+        throw runtime_error("Couldn't write " + settings.output);
+    }
+
+    file << "scene,status,mean_delta_e,max_delta_e,changed_pixels_percent,"
+            "cpu_ms,gpu_ms,note\n";
+    for (auto const &result : results) {
+        file << result.scene << ','
+             << (result.passed ? "pass" : "fail") << ','
+             << result.meanDeltaE << ','
+             << result.maxDeltaE << ','
+             << 100.0f * result.changedPixels << ','
+             << result.cpuTime << ','
+             << result.gpuTime << ','
+             << result.note << '\n';
+    }
+}
+
+int Regression::failures() const {
+    int failures = 0;
+    for (auto const &result : results) {
+        if (!result.passed) {
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// ============================================== Private implementation ==
+// ----------------------------------------------------------- Behaviour --
+string Regression::referencePath() const {
+    return settings.references + "/" + scene().name + ".ppm";
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,83 @@
+#ifndef REGRESSION_H
+#define REGRESSION_H
+// //////////////////////////////////////////////////////////// Includes //
+#include <functional>
+#include <string>
+#include <vector>
+
+// ////////////////////////////////////////// Struct: RegressionSettings //
+struct RegressionSettings {
+    int width, height;
+    std::string references;
+    std::string output;
+    bool update;
+
+    // CIE76 colour difference above which a pixel counts as changed
+    float tolerance;
+
+    // Fraction of changed pixels a scene may have and still pass
+    float maxChangedPixels;
+};
+
+// ///////////////////////////////////////////// Struct: RegressionScene //
+struct RegressionScene {
+    std::string name;
+
+    // Puts the game into the scene's state, called before every frame
+    std::function<void()> apply;
+};
+
+// /////////////////////////////////////////////////// Class: Regression //
+// Renders each scene for a few frames, then compares the last one against
+// a stored reference image and keeps the frame timings of the scene.
+class Regression {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    static constexpr int FRAMES_PER_SCENE = 8;
+
+    // ---------------------------------------------------------- Result --
+    struct Result {
+        std::string scene;
+        bool passed;
+        std::string note;
+        float meanDeltaE, maxDeltaE, changedPixels;
+        float cpuTime, gpuTime;
+    };
+
+    // ------------------------------------------------------- Behaviour --
+    Regression(RegressionSettings const &settings,
+               std::vector<RegressionScene> const &scenes);
+
+    bool finished() const;
+    RegressionScene const &scene() const;
+
+    // Whether the current frame is the one compared to the reference
+    bool capturing() const;
+    void advance();
+
+    // gpuTime is negative when the frame's GPU timings were unavailable
+    void recordTiming(float const cpuTime, float const gpuTime);
+
+    // Compares tightly packed RGB rows, top row first, to the reference
+    // or replaces the reference when updating
+    void recordFrame(std::vector<unsigned char> const &pixels);
+
+    void writeResults() const;
+    int failures() const;
+
+    // ------------------------------------------------------------ Data --
+    RegressionSettings const settings;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------- Behaviour --
+    std::string referencePath() const;
+
+    // ------------------------------------------------------------ Data --
+    std::vector<RegressionScene> const scenes;
+    std::vector<Result> results;
+    std::vector<float> cpuTimes, gpuTimes;
+    int sceneIndex, frame;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // REGRESSION_H
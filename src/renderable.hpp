@@ -2,14 +2,27 @@
 #define RENDERABLE_H
 
 #include <memory>
+#include <vector>
 #include "opengl-headers.hpp"
 #include "shader.hpp"
+#include "bounding-volume.hpp"
 
 class Renderable {
 public:
     std::shared_ptr<Shader> shader;
+    BoundingBox boundingBox = BoundingBox::unbounded();
 
-    virtual void render(std::shared_ptr<Shader> shader) const = 0;
+    // Level of detail 0 is the full mesh, higher ones are coarser. Model
+    // shaders read the DrawParameters of mesh m, instance k at
+    // firstDraw + m * instances + k.
+    virtual void render(std::shared_ptr<Shader> shader, int const lod = 0,
+                        int const instances = 1,
+                        int const firstDraw = 0) const = 0;
+    virtual int lodCount() const { return 1; }
+
+    // MaterialTable index of every mesh, empty for what doesn't use
+    // per-draw data
+    virtual std::vector<int> materials() const { return {}; }
     virtual ~Renderable() {}
 };
 
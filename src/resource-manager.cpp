@@ -0,0 +1,291 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "resource-manager.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::cerr;
+using std::deque;
+using std::endl;
+using std::runtime_error;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+using resources::Category;
+using resources::Handle;
+using resources::Type;
+using resources::Usage;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    struct Object {
+        GLuint name;
+        Type type;
+        Category category;
+        uint64_t bytes;
+    };
+
+    struct Slot {
+        Object object;
+        uint32_t generation;
+        bool live;
+    };
+
+    // Objects released during one frame and the fence that ends it
+    struct Batch {
+        GLsync fence;
+        vector<Object> objects;
+    };
+
+    // Plain flag rather than part of State: it stays readable while
+    // objects with static storage are destroyed after State is
+    bool active = false;
+
+    struct State {
+        vector<Slot> slots;
+        vector<uint32_t> freeSlots;
+        vector<Object> released;
+        deque<Batch> batches;
+        Usage live[resources::CATEGORY_COUNT]{};
+        Usage waiting{};
+
+        State() {
+            active = true;
+        }
+
+        ~State() {
+            active = false;
+        }
+    } state;
+
+    void add(Usage &usage, Object const &object) {
+        usage.objects++;
+        usage.bytes += object.bytes;
+    }
+
+    void subtract(Usage &usage, Object const &object) {
+        usage.objects--;
+        usage.bytes -= object.bytes;
+    }
+
+    void destroy(Object const &object) {
+        switch (object.type) {
+            case resources::TYPE_TEXTURE:
+                glDeleteTextures(1, &object.name);
+                break;
+            case resources::TYPE_BUFFER:
+                glDeleteBuffers(1, &object.name);
+                break;
+            case resources::TYPE_VERTEX_ARRAY:
+                glDeleteVertexArrays(1, &object.name);
+                break;
+            case resources::TYPE_FRAMEBUFFER:
+                glDeleteFramebuffers(1, &object.name);
+                break;
+            case resources::TYPE_RENDERBUFFER:
+                glDeleteRenderbuffers(1, &object.name);
+                break;
+        }
+        subtract(state.waiting, object);
+    }
+
+    void destroy(Batch const &batch) {
+        for (auto const &object : batch.objects) {
+            destroy(object);
+        }
+        glDeleteSync(batch.fence);
+    }
+
+    uint64_t texelBytes(GLenum const internalFormat) {
+        switch (internalFormat) {
+            case GL_R8:
+                return 1;
+            case GL_RG8:
+            case GL_R16F:
+                return 2;
+            case GL_RGB8:
+            case GL_SRGB8:
+            case GL_RGBA8:
+            case GL_SRGB8_ALPHA8:
+            case GL_RG16F:
+            case GL_R32F:
+            case GL_R11F_G11F_B10F:
+            case GL_DEPTH_COMPONENT24:
+            case GL_DEPTH_COMPONENT32F:
+            case GL_DEPTH24_STENCIL8:
+                return 4;
+            case GL_RGB16F:
+            case GL_RGBA16F:
+            case GL_RG32F:
+                return 8;
+            case GL_RGB32F:
+            case GL_RGBA32F:
+                return 16;
+            default:
+                return 4;
+        }
+    }
+}
+
+// ///////////////////////////////////////////////////// Resource manager //
+char const *resources::categoryName(Category const category) {
+    switch (category) {
+        case CATEGORY_GEOMETRY:
+            return "Geometry";
+        case CATEGORY_TEXTURES:
+            return "Textures";
+        case CATEGORY_TARGETS:
+            return "Render targets";
+        case CATEGORY_STREAMING:
+            return "Streaming";
+        case CATEGORY_STATE:
+            return "State objects";
+        default:
+            return "Unknown";
+    }
+}
+
+resources::Handle::operator bool() const {
+    return generation != 0;
+}
+
+Handle resources::create(Type const type, GLuint const name,
+                         Category const category, uint64_t const bytes) {
+    uint32_t index;
+    if (state.freeSlots.empty()) {
+        index = static_cast<uint32_t>(state.slots.size());
+        state.slots.push_back(Slot{{}, 1, false});
+    } else {
+        index = state.freeSlots.back();
+        state.freeSlots.pop_back();
+    }
+
+    Slot &slot = state.slots[index];
+    slot.object = Object{name, type, category, bytes};
+    slot.live = true;
+    add(state.live[category], slot.object);
+
+    return Handle{index, slot.generation};
+}
+
+GLuint resources::name(Handle const handle) {
+    if (!handle) {
+        return 0;
+    }
+    if (handle.index >= state.slots.size() ||
+        state.slots[handle.index].generation != handle.generation) {
+        throw runtime_error("Stale GPU resource handle!");
+    }
+    return state.slots[handle.index].object.name;
+}
+
+void resources::release(Handle const handle) {
+    if (!handle || !active || handle.index >= state.slots.size()) {
+        return;
+    }
+    Slot &slot = state.slots[handle.index];
+    if (slot.generation != handle.generation || !slot.live) {
+        return;
+    }
+
+    subtract(state.live[slot.object.category], slot.object);
+    add(state.waiting, slot.object);
+    state.released.push_back(slot.object);
+
+    // Skips 0 when it wraps around, that one means no object
+    slot.live = false;
+    slot.generation = std::max(slot.generation + 1, 1u);
+    state.freeSlots.push_back(handle.index);
+}
+
+void resources::beginFrame() {
+    while (!state.batches.empty()) {
+        GLenum const status = glClientWaitSync(state.batches.front().fence,
+                                               0, 0);
+        if (status != GL_ALREADY_SIGNALED &&
+            status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        destroy(state.batches.front());
+        state.batches.pop_front();
+    }
+}
+
+void resources::endFrame() {
+    if (state.released.empty()) {
+        return;
+    }
+    state.batches.push_back(Batch{
+            glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+            std::move(state.released)
+    });
+    state.released.clear();
+}
+
+Usage resources::usage(Category const category) {
+    return state.live[category];
+}
+
+Usage resources::total() {
+    Usage sum{};
+    for (auto const &usage : state.live) {
+        sum.objects += usage.objects;
+        sum.bytes += usage.bytes;
+    }
+    return sum;
+}
+
+Usage resources::pending() {
+    return state.waiting;
+}
+
+void resources::shutdown() {
+    glFinish();
+    for (auto const &batch : state.batches) {
+        destroy(batch);
+    }
+    state.batches.clear();
+    for (auto const &object : state.released) {
+        destroy(object);
+    }
+    state.released.clear();
+
+    for (int category = 0; category < CATEGORY_COUNT; ++category) {
+        Usage const &usage = state.live[category];
+        if (usage.objects > 0) {
+            cerr << "GPU resources still alive: "
+                 << categoryName(static_cast<Category>(category)) << ", "
+                 << usage.objects << " objects, " << usage.bytes
+                 << " bytes" << endl;
+        }
+    }
+
+    // The context goes away next; whatever is released later leaks
+    // with it
+    active = false;
+}
+
+uint64_t resources::textureBytes(GLenum const target,
+                                 GLenum const internalFormat,
+                                 int const levels, int const width,
+                                 int const height, int const depth) {
+    uint64_t const faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    uint64_t bytes = 0;
+    for (int level = 0; level < levels; ++level) {
+        uint64_t const levelWidth = std::max(width >> level, 1);
+        uint64_t const levelHeight = std::max(height >> level, 1);
+        uint64_t const levelDepth = target == GL_TEXTURE_3D
+                                    ? std::max(depth >> level, 1)
+                                    : depth;
+        bytes += levelWidth * levelHeight * levelDepth * faces;
+    }
+    return bytes * texelBytes(internalFormat);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
@@ -0,0 +1,86 @@
+#ifndef RESOURCE_MANAGER_H
+#define RESOURCE_MANAGER_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "opengl-headers.hpp"
+
+#include <cstdint>
+
+// ///////////////////////////////////////////////////// Resource manager //
+// Registry of the OpenGL objects owned through gl-resources.hpp. Owners
+// hold handles: a slot index and the generation the slot had when the
+// object was registered. Releasing an object bumps the generation, so a
+// handle kept past its owner no longer resolves to a name that may since
+// have been reused.
+//
+// Released objects aren't deleted right away. They wait for a fence
+// placed at the end of the frame that released them, since commands
+// already submitted may still read them, and are deleted once the GPU
+// has passed it. Live objects are counted by category with an estimate
+// of their memory, which has to stay flat while scenes come and go.
+namespace resources {
+    enum Type {
+        TYPE_TEXTURE,
+        TYPE_BUFFER,
+        TYPE_VERTEX_ARRAY,
+        TYPE_FRAMEBUFFER,
+        TYPE_RENDERBUFFER
+    };
+
+    enum Category {
+        CATEGORY_GEOMETRY,
+        CATEGORY_TEXTURES,
+        CATEGORY_TARGETS,
+        CATEGORY_STREAMING,
+        CATEGORY_STATE,
+        CATEGORY_COUNT
+    };
+
+    char const *categoryName(Category const category);
+
+    // Generation 0 is never issued: a default handle refers to nothing
+    struct Handle {
+        std::uint32_t index = 0;
+        std::uint32_t generation = 0;
+
+        explicit operator bool() const;
+    };
+
+    struct Usage {
+        std::uint64_t objects;
+        std::uint64_t bytes;
+    };
+
+    Handle create(Type const type, GLuint const name,
+                  Category const category, std::uint64_t const bytes);
+
+    // 0 for a default handle; throws for a released one
+    GLuint name(Handle const handle);
+
+    // Queues the object for deletion after the current frame
+    void release(Handle const handle);
+
+    // Deletes the objects of frames the GPU has finished
+    void beginFrame();
+
+    // Fences the objects released during the frame
+    void endFrame();
+
+    Usage usage(Category const category);
+    Usage total();
+
+    // Released but not yet deleted
+    Usage pending();
+
+    // Waits for the GPU, deletes everything queued and reports objects
+    // still alive; call before the context goes away
+    void shutdown();
+
+    // Estimated size of a texture's storage; formats the driver may pad,
+    // such as RGB8, are counted at their padded size
+    std::uint64_t textureBytes(GLenum const target, GLenum const internalFormat,
+                               int const levels, int const width,
+                               int const height, int const depth);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // RESOURCE_MANAGER_H
@@ -0,0 +1,44 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "shader-permutations.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+// /////////////////////////////////////////// Class: ShaderPermutations //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+ShaderPermutations::ShaderPermutations(string const &vertexShaderFilename,
+                                       string const &geometryShaderFilename,
+                                       string const &fragmentShaderFilename)
+        : vertexShaderFilename(vertexShaderFilename),
+          geometryShaderFilename(geometryShaderFilename),
+          fragmentShaderFilename(fragmentShaderFilename) {
+}
+
+shared_ptr<Shader> ShaderPermutations::get(ShaderDefines const &defines) {
+    shared_ptr<Shader> &shader = permutations[defines];
+    if (!shader) {
+        shader = make_shared<Shader>(vertexShaderFilename,
+                                     geometryShaderFilename,
+                                     fragmentShaderFilename,
+                                     defines);
+    }
+    return shader;
+}
+
+vector<shared_ptr<Shader>> ShaderPermutations::compiled() const {
+    vector<shared_ptr<Shader>> shaders;
+    for (auto const &permutation : permutations) {
+        shaders.push_back(permutation.second);
+    }
+    return shaders;
+}
+
+// ///////////////////////////////////////////////////////////////////// //
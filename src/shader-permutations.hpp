@@ -0,0 +1,34 @@
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "shader.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// /////////////////////////////////////////// Class: ShaderPermutations //
+// Specialised variants of one shader, compiled on first request and kept
+// by their defines.
+class ShaderPermutations {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    ShaderPermutations(std::string const &vertexShaderFilename,
+                       std::string const &geometryShaderFilename,
+                       std::string const &fragmentShaderFilename);
+
+    std::shared_ptr<Shader> get(ShaderDefines const &defines);
+
+    // Every permutation compiled so far
+    std::vector<std::shared_ptr<Shader>> compiled() const;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------------ Data --
+    std::string const vertexShaderFilename, geometryShaderFilename,
+            fragmentShaderFilename;
+    std::map<ShaderDefines, std::shared_ptr<Shader>> permutations;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // SHADER_PERMUTATIONS_H
@@ -1,25 +1,38 @@
 // //////////////////////////////////////////////////////////// Includes //
 #include "shader.hpp"
 #include "opengl-headers.hpp"
-
+#include "frame-stats.hpp"
+#include "cache.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
 #include <fstream>
+#include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 // ////////////////////////////////////////////////////////////// Usings //
+using std::cerr;
 using std::endl;
 using std::exception;
 using std::ifstream;
 using std::ios;
+using std::runtime_error;
 using std::string;
 using std::stringstream;
+using std::vector;
 
 // ///////////////////////////////////////////////////////////// Helpers //
 string loadFile(string const &filename) {
     // '''''''''''''''''''''''''''''''''''''''''''''''''''''''''' Open file
     ifstream file(filename);
     if (!file) {
-        throw exception(("Couldn't load " + filename).c_str());
+        throw runtime_error(("Couldn't load " + filename).c_str());
     }
 
     // '''''''''''''''''''''''''''''''''''''''''''''''''''''' Get file size
@@ -35,6 +48,72 @@ string loadFile(string const &filename) {
     return buffer;
 }
 
+// Paths are compared in one spelling: "model/../include/pbr.glsl" and
+// "include/pbr.glsl" are the same file to the file watcher
+string normalPath(string const &filename) {
+    return std::filesystem::path(filename).lexically_normal()
+            .generic_string();
+}
+
+// Appends the file with its #include "..." lines expanded, relative to
+// the including file; every file is included once. #line directives
+// number the files in order of appearance, so that compiler messages
+// point at the right one.
+void expandIncludes(string const &path,
+                    ShaderDefines const &defines,
+                    vector<string> &files,
+                    stringstream &output) {
+    string const filename = normalPath(path);
+    for (string const &file : files) {
+        if (file == filename) {
+            return;
+        }
+    }
+    size_t const fileIndex = files.size();
+    files.push_back(filename);
+
+    string const directory = filename.substr(0, filename.rfind('/') + 1);
+
+    stringstream input(loadFile(filename));
+    string line;
+    for (int number = 1; std::getline(input, line); ++number) {
+        size_t const start = line.find_first_not_of(" \t");
+        if (start != string::npos &&
+            line.compare(start, 8, "#include") == 0) {
+            size_t const open = line.find('"', start);
+            size_t const close = line.find('"', open + 1);
+            if (open == string::npos || close == string::npos) {
+                throw runtime_error(filename + ":" + std::to_string(number) +
+                                    ": malformed #include");
+            }
+
+            expandIncludes(directory +
+                           line.substr(open + 1, close - open - 1),
+                           defines, files, output);
+            output << "#line " << number + 1 << ' ' << fileIndex << '\n';
+        } else if (start != string::npos && fileIndex == 0 &&
+                   line.compare(start, 8, "#version") == 0) {
+            // Permutation defines go right after the version directive
+            output << line << '\n';
+            for (auto const &define : defines) {
+                output << "#define " << define.first << ' '
+                       << define.second << '\n';
+            }
+            output << "#line " << number + 1 << ' ' << fileIndex << '\n';
+        } else {
+            output << line << '\n';
+        }
+    }
+}
+
+string preprocess(string const &filename,
+                  ShaderDefines const &defines,
+                  vector<string> &files) {
+    stringstream output;
+    expandIncludes(filename, defines, files, output);
+    return output.str();
+}
+
 void checkForCompileErrors(int const shader) {
     int compiledSuccessfully;
 
@@ -50,17 +129,23 @@ void checkForCompileErrors(int const shader) {
         message << "Failed to compile shader!" << endl
                 << infoLog;
 
-        throw exception(message.str().c_str());
+        throw runtime_error(message.str().c_str());
     }
 }
 
-void compile(int const shader,
-             string const &source) {
+// Starts compiling a stage and attaches it, errors are checked on wait
+int submitStage(int const program,
+                GLenum const type,
+                string const &source) {
+    int const shader = glCreateShader(type);
+
     char const *shaderSource = source.c_str();
     glShaderSource(shader, 1, &shaderSource, nullptr);
 
     glCompileShader(shader);
-    checkForCompileErrors(shader);
+    glAttachShader(program, shader);
+
+    return shader;
 }
 
 void checkForLinkingErrors(int const shader) {
@@ -78,23 +163,113 @@ void checkForLinkingErrors(int const shader) {
         message << "Failed to link shader!" << endl
                 << infoLog;
 
-        throw exception(message.str().c_str());
+        throw runtime_error(message.str().c_str());
     }
 }
 
-int link(int const vertex,
-         int const geometry,
-         int const fragment) {
-    int shader = glCreateProgram();
+// From KHR_parallel_shader_compile, which glad was generated without
+GLenum const COMPLETION_STATUS_KHR = 0x91B1;
+
+bool parallelCompileSupported() {
+    static bool const supported = []() {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            char const *extension = reinterpret_cast<char const *>(
+                    glGetStringi(GL_EXTENSIONS, i));
+            if (std::strcmp(extension,
+                            "GL_KHR_parallel_shader_compile") == 0 ||
+                std::strcmp(extension,
+                            "GL_ARB_parallel_shader_compile") == 0) {
+                return true;
+            }
+        }
+        return false;
+    }();
+    return supported;
+}
 
-    glAttachShader(shader, vertex);
-    glAttachShader(shader, geometry);
-    glAttachShader(shader, fragment);
+// Cached program: this header, then the driver's binary
+struct ProgramBinaryHeader {
+    std::uint32_t magic;
+    std::uint32_t format;
+    std::uint32_t size;
+};
+
+std::uint32_t const PROGRAM_BINARY_MAGIC = 0x31435046u;
+
+// Cache entry for a program, keyed by its sources and the driver that
+// compiles them; empty when binaries can't be cached
+string programBinaryCacheFile(vector<string> const &sources) {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats == 0) {
+        return string();
+    }
 
-    glLinkProgram(shader);
-    checkForLinkingErrors(shader);
+    string const directory = cache::directory("shaders");
+    if (directory.empty()) {
+        return string();
+    }
 
-    return shader;
+    std::uint64_t key = cache::HASH_SEED;
+    for (GLenum const name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        key = cache::hash(reinterpret_cast<char const *>(glGetString(name)),
+                          key);
+        key = cache::hash("", 1, key);
+    }
+    for (string const &source : sources) {
+        key = cache::hash(source, key);
+        key = cache::hash("", 1, key);
+    }
+    return directory + "/" + cache::hex(key) + ".bin";
+}
+
+bool loadProgramBinary(int const shader, string const &filename) {
+    vector<char> data;
+    if (filename.empty() || !cache::read(filename, data) ||
+        data.size() < sizeof(ProgramBinaryHeader)) {
+        return false;
+    }
+
+    ProgramBinaryHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != PROGRAM_BINARY_MAGIC ||
+        header.size != data.size() - sizeof(header)) {
+        return false;
+    }
+
+    // Drivers reject binaries from other versions, the program then stays
+    // unlinked and is built from source instead
+    glProgramBinary(shader, header.format, data.data() + sizeof(header),
+                    header.size);
+
+    int linkedSuccessfully;
+    glGetProgramiv(shader, GL_LINK_STATUS, &linkedSuccessfully);
+    return linkedSuccessfully;
+}
+
+void saveProgramBinary(int const shader, string const &filename) {
+    if (filename.empty()) {
+        return;
+    }
+
+    int size = 0;
+    glGetProgramiv(shader, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0) {
+        return;
+    }
+
+    vector<char> data(sizeof(ProgramBinaryHeader) + size);
+    GLenum format;
+    glGetProgramBinary(shader, size, nullptr, &format,
+                       data.data() + sizeof(ProgramBinaryHeader));
+
+    ProgramBinaryHeader const header = {
+            PROGRAM_BINARY_MAGIC, format, static_cast<std::uint32_t>(size)};
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    cache::write(filename, data);
 }
 
 // /////////////////////////////////////////////////////// Class: Shader //
@@ -102,62 +277,246 @@ int link(int const vertex,
 // ----------------------------------------------------------- Behaviour --
 Shader::Shader(string const &vertexShaderFilename,
                string const &geometryShaderFilename,
-               string const &fragmentShaderFilename)
-    : shader([&]() -> int {
-          int const vertex = glCreateShader(GL_VERTEX_SHADER),
-                    geometry = glCreateShader(GL_GEOMETRY_SHADER),
-                    fragment = glCreateShader(GL_FRAGMENT_SHADER);
+               string const &fragmentShaderFilename,
+               ShaderDefines const &defines)
+    : filenames{vertexShaderFilename,
+                geometryShaderFilename,
+                fragmentShaderFilename},
+      types{GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER},
+      defines(defines),
+      current(startBuild()),
+      reloading(false) {
+    // Submit everything at once, the driver may compile on its own threads
+    while (!submitNextStage(current)) {
+    }
+}
 
-          compile(vertex, loadFile(vertexShaderFilename));
-          compile(geometry, loadFile(geometryShaderFilename));
-          compile(fragment, loadFile(fragmentShaderFilename));
+Shader::Shader(string const &vertexShaderFilename,
+               string const &fragmentShaderFilename,
+               ShaderDefines const &defines)
+    : filenames{vertexShaderFilename, fragmentShaderFilename},
+      types{GL_VERTEX_SHADER, GL_FRAGMENT_SHADER},
+      defines(defines),
+      current(startBuild()),
+      reloading(false) {
+    while (!submitNextStage(current)) {
+    }
+}
+
+Shader::Shader(string const &computeShaderFilename,
+               ShaderDefines const &defines)
+    : filenames{computeShaderFilename},
+      types{GL_COMPUTE_SHADER},
+      defines(defines),
+      current(startBuild()),
+      reloading(false) {
+    while (!submitNextStage(current)) {
+    }
+}
 
-          int const shader = link(vertex, geometry, fragment);
+Shader::~Shader() {
+    deleteBuild(current);
+    if (reloading) {
+        deleteBuild(pending);
+    }
+}
 
-          glDeleteShader(fragment);
-          glDeleteShader(geometry);
-          glDeleteShader(vertex);
+bool Shader::ready() const {
+    return current.linked || completed(current);
+}
 
-          return shader;
-      }()) {
+void Shader::wait() {
+    if (!current.linked) {
+        finishBuild(current);
+    }
 }
 
-Shader::~Shader() {
-    glDeleteProgram(shader);
+bool Shader::uses(string const &filename) const {
+    string const file = normalPath(filename);
+    for (string const &own : current.files) {
+        if (own == file) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void Shader::use() const {
-    glUseProgram(shader);
+void Shader::reload() {
+    if (reloading) {
+        deleteBuild(pending);
+        reloading = false;
+    }
+
+    // Files may be missing for a moment while an editor saves them
+    try {
+        pending = startBuild();
+        reloading = true;
+    } catch (exception const &error) {
+        cerr << error.what() << endl;
+    }
+}
+
+bool Shader::update() {
+    if (!reloading) {
+        return false;
+    }
+
+    // One stage per frame, in case the driver compiles synchronously
+    if (!submitNextStage(pending) || !completed(pending)) {
+        return false;
+    }
+    reloading = false;
+
+    try {
+        finishBuild(pending);
+    } catch (exception const &error) {
+        cerr << "Keeping the previous program: " << error.what() << endl;
+        deleteBuild(pending);
+        return false;
+    }
+
+    deleteBuild(current);
+    current = pending;
+    locations.clear();
+    return true;
+}
+
+void Shader::use() {
+    gl::useProgram(program());
 }
 
 void Shader::uniformMatrix4fv(string const &name,
                               float const *value) {
-    glUniformMatrix4fv(
-        glGetUniformLocation(shader, name.c_str()), 1, false, value);
+    int const location = this->location(name);
+    if (location >= 0) {
+        gl::uniformMatrix4fv(location, 1, false, value);
+    }
+}
+
+void Shader::uniform2f(string const &name, float const a, float const b) {
+    int const location = this->location(name);
+    if (location >= 0) {
+        gl::uniform2f(location, a, b);
+    }
 }
 
 void Shader::uniform3f(string const &name,
                        float const a,
                        float const b,
                        float const c) {
-    glUniform3f(
-        glGetUniformLocation(shader, name.c_str()),
-        a, b, c);
+    int const location = this->location(name);
+    if (location >= 0) {
+        gl::uniform3f(location, a, b, c);
+    }
 }
 
 void Shader::uniform3f(std::string const &name, glm::vec3 const &abc) {
-    glUniform3f(
-            glGetUniformLocation(shader, name.c_str()),
-            abc.x, abc.y, abc.z);
+    uniform3f(name, abc.x, abc.y, abc.z);
 }
 
 
 void Shader::uniform1i(string const &name, int const a) {
-    glUniform1i(
-        glGetUniformLocation(shader, name.c_str()), a);
+    int const location = this->location(name);
+    if (location >= 0) {
+        gl::uniform1i(location, a);
+    }
 }
 
 void Shader::uniform1f(std::string const &name, float const a) {
-    glUniform1f(
-            glGetUniformLocation(shader, name.c_str()), a);
+    int const location = this->location(name);
+    if (location >= 0) {
+        gl::uniform1f(location, a);
+    }
+}
+
+// ============================================== Private implementation ==
+// ----------------------------------------------------------- Behaviour --
+Shader::Build Shader::startBuild() const {
+    Build build = {0, {}, {}, types, {}, string(), false};
+    for (string const &filename : filenames) {
+        vector<string> files;
+        build.sources.push_back(preprocess(filename, defines, files));
+
+        for (string const &file : files) {
+            if (std::find(build.files.begin(), build.files.end(), file) ==
+                build.files.end()) {
+                build.files.push_back(file);
+            }
+        }
+    }
+
+    // Reuse the driver's binary from a previous run if possible
+    build.cacheFile = programBinaryCacheFile(build.sources);
+    build.program = glCreateProgram();
+    build.linked = loadProgramBinary(build.program, build.cacheFile);
+
+    return build;
+}
+
+bool Shader::submitNextStage(Build &build) {
+    if (build.linked || build.stages.size() == build.sources.size()) {
+        return true;
+    }
+
+    size_t const stage = build.stages.size();
+    build.stages.push_back(submitStage(build.program, build.types[stage],
+                                       build.sources[stage]));
+    if (build.stages.size() < build.sources.size()) {
+        return false;
+    }
+
+    glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                        GL_TRUE);
+    glLinkProgram(build.program);
+    return true;
+}
+
+bool Shader::completed(Build const &build) {
+    if (build.linked || !parallelCompileSupported()) {
+        return true;
+    }
+
+    int completed;
+    glGetProgramiv(build.program, COMPLETION_STATUS_KHR, &completed);
+    return completed;
+}
+
+void Shader::finishBuild(Build &build) {
+    for (int const stage : build.stages) {
+        checkForCompileErrors(stage);
+    }
+    checkForLinkingErrors(build.program);
+
+    for (int const stage : build.stages) {
+        glDetachShader(build.program, stage);
+        glDeleteShader(stage);
+    }
+    build.stages.clear();
+
+    saveProgramBinary(build.program, build.cacheFile);
+    build.linked = true;
+}
+
+void Shader::deleteBuild(Build &build) {
+    for (int const stage : build.stages) {
+        glDeleteShader(stage);
+    }
+    build.stages.clear();
+    glDeleteProgram(build.program);
+}
+
+int Shader::program() {
+    wait();
+    return current.program;
+}
+
+int Shader::location(string const &name) {
+    auto const cached = locations.find(name);
+    if (cached != locations.end()) {
+        return cached->second;
+    }
+
+    int const location = glGetUniformLocation(program(), name.c_str());
+    locations.emplace(name, location);
+    return location;
 }
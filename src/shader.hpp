@@ -1,23 +1,62 @@
 #ifndef SHADER_H
 #define SHADER_H
+#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <glm/vec3.hpp>
 
+// ////////////////////////////////////////////////////// ShaderDefines //
+// Preprocessor definitions that select a permutation of a shader
+using ShaderDefines = std::map<std::string, std::string>;
+
 // /////////////////////////////////////////////////////// Class: Shader //
+// Sources may #include "file" relative to themselves; the defines are
+// injected right after #version.
 class Shader {
 public: // ============================================ Public interface ==
     // ------------------------------------------------------- Behaviour --
+    // Submits compilation and linking without waiting for the driver
     Shader(std::string const &vertexShaderFilename,
            std::string const &geometryShaderFilename,
-           std::string const &fragmentShaderFilename);
+           std::string const &fragmentShaderFilename,
+           ShaderDefines const &defines = ShaderDefines());
+
+    // Program without a geometry stage
+    Shader(std::string const &vertexShaderFilename,
+           std::string const &fragmentShaderFilename,
+           ShaderDefines const &defines = ShaderDefines());
+
+    // Compute program
+    explicit Shader(std::string const &computeShaderFilename,
+                    ShaderDefines const &defines = ShaderDefines());
 
     ~Shader();
 
-    void use() const;
+    // Whether wait() would return without blocking; always true when
+    // the driver can't compile in the background
+    bool ready() const;
+
+    // Blocks until the program is linked, throws on compile or link
+    // errors; called implicitly before the program is first used
+    void wait();
+
+    // Hot reloading: uses() covers included files as well, reload()
+    // starts rebuilding from the files while the current program stays
+    // in use, update() advances the rebuild and returns true once the new
+    // program has replaced the old one. On errors the old program is kept
+    // and the log goes to stderr.
+    bool uses(std::string const &filename) const;
+    void reload();
+    bool update();
+
+    void use();
 
     void uniformMatrix4fv(std::string const &name,
                           float const *value);
 
+    void uniform2f(std::string const &name, float const a, float const b);
+
     void uniform3f(std::string const &name,
             float const a, float const b, float const c);
     void uniform3f(std::string const &name, glm::vec3 const &abc);
@@ -26,8 +65,38 @@ public: // ============================================ Public interface ==
     void uniform1f(std::string const &name, float const a);
 
 private: // ===================================== Private implementation == 
+    // ----------------------------------------------------------- Build --
+    struct Build {
+        int program;
+        std::vector<std::string> sources;
+        std::vector<std::string> files;
+        std::vector<unsigned> types;
+        std::vector<int> stages;
+        std::string cacheFile;
+        bool linked;
+    };
+
+    // ------------------------------------------------------- Behaviour --
+    Build startBuild() const;
+
+    // Returns true once every stage is submitted and the link started
+    static bool submitNextStage(Build &build);
+    static bool completed(Build const &build);
+    static void finishBuild(Build &build);
+    static void deleteBuild(Build &build);
+
+    int program();
+
+    // Uniform locations change when the program is replaced
+    int location(std::string const &name);
+
     // ------------------------------------------------------------ Data --
-    int const shader;
+    std::vector<std::string> const filenames;
+    std::vector<unsigned> const types;
+    ShaderDefines const defines;
+    Build current, pending;
+    bool reloading;
+    std::unordered_map<std::string, int> locations;
 };
 // ///////////////////////////////////////////////////////////////////// //
 #endif // SHADER_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "opengl-headers.hpp"
+#include "gl-resources.hpp"
 
 // //////////////////////////////////////////////////// Class: ShadowMap //
 class ShadowMap {
@@ -9,46 +10,30 @@ public:
     }
 
     int const width, height;
-    GLuint depthMapFBO, depthMapTexture;
+    gl::Framebuffer depthMapFBO;
+    gl::Texture depthMapTexture;
 
 private:
     void setup(int const width, int const height) {
-        // Generate OpenGL resources
-        glGenFramebuffers(1, &depthMapFBO);
-        glGenTextures(1, &depthMapTexture);
-
-        // Setup the texture
-        glBindTexture(GL_TEXTURE_2D, depthMapTexture);
-        {
-            // Set texture parameters
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
-                            GL_CLAMP_TO_BORDER);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
-                            GL_CLAMP_TO_BORDER);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                            GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-                            GL_NEAREST);
-
-            float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR,
-                             borderColor);
-
-            // Pass image to OpenGL
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
-                         width, height, 0, GL_DEPTH_COMPONENT,
-                         GL_FLOAT, 0);
-
-            // Bind depth texture to framebuffer
-            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-            {
-                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-                                       GL_TEXTURE_2D, depthMapTexture, 0);
-                glDrawBuffer(GL_NONE);
-                glReadBuffer(GL_NONE);
-            }
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        }
+        depthMapTexture = gl::Texture(GL_TEXTURE_2D, 1,
+                                      GL_DEPTH_COMPONENT24, width, height,
+                                      1, resources::CATEGORY_TARGETS);
+
+        // Set texture parameters
+        depthMapTexture.parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        depthMapTexture.parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        depthMapTexture.parameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        depthMapTexture.parameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+        depthMapTexture.parameter(GL_TEXTURE_BORDER_COLOR, borderColor);
+
+        // Depth only, nothing to draw or read colours from
+        depthMapFBO = gl::Framebuffer::create();
+        depthMapFBO.attach(GL_DEPTH_ATTACHMENT, depthMapTexture);
+        depthMapFBO.drawBuffers({GL_NONE});
+        depthMapFBO.readBuffer(GL_NONE);
+        depthMapFBO.check();
     }
 };
 
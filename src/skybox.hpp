@@ -5,20 +5,20 @@
 #include "renderable.hpp"
 
 #include "opengl-headers.hpp"
+#include "frame-stats.hpp"
+#include "gl-resources.hpp"
 
 #include <string>
 #include <vector>
 #include <memory>
 
-using namespace std;
-
-GLuint loadCubemapFromFile(vector<string> const &filenames);
+gl::Texture loadCubemapFromFile(std::vector<std::string> const &filenames);
 
 // /////////////////////////////////////////////////////// Class: Skybox //
 class Skybox : public Renderable {
 public:
     Skybox() {
-        vertices = vector<glm::vec3> {
+        vertices = std::vector<glm::vec3> {
                 {-1.0f,  1.0f, -1.0f},
                 {-1.0f, -1.0f, -1.0f},
                 {1.0f, -1.0f, -1.0f},
@@ -61,28 +61,30 @@ public:
                 {-1.0f, -1.0f,  1.0f},
                 {1.0f, -1.0f,  1.0f}
         };
-        cubemap = loadCubemapFromFile( {
-                        "res/textures/skybox/right.jpg",
-                        "res/textures/skybox/left.jpg",
-                        "res/textures/skybox/top.jpg",
-                        "res/textures/skybox/bottom.jpg",
-                        "res/textures/skybox/front.jpg",
-                        "res/textures/skybox/back.jpg"
-                });
+        filenames = {
+                "res/textures/skybox/right.jpg",
+                "res/textures/skybox/left.jpg",
+                "res/textures/skybox/top.jpg",
+                "res/textures/skybox/bottom.jpg",
+                "res/textures/skybox/front.jpg",
+                "res/textures/skybox/back.jpg"
+        };
+        cubemap = loadCubemapFromFile(filenames);
         setupSkybox();
     }
 
-    void render(std::shared_ptr<Shader> shader) const {
+    void render(std::shared_ptr<Shader> shader, int const lod = 0,
+                int const instances = 1, int const firstDraw = 0) const {
         glDepthMask(GL_FALSE);
 
         shader->use();
         shader->uniform1i("texSkybox", 5);
 
         glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
-        glBindVertexArray(vao);
+        gl::bindTexture(GL_TEXTURE_CUBE_MAP, cubemap.id());
+        vao.bind();
         {
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            gl::drawArrays(GL_TRIANGLES, 0, 36);
         }
 
         glDepthMask(GL_TRUE);
@@ -90,22 +92,19 @@ public:
 
 public:
     void setupSkybox() {
-        glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &vbo);
+        vbo = gl::Buffer(vertices.size() * sizeof(glm::vec3),
+                         vertices.data());
 
-        glBindVertexArray(vao); {
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), &vertices[0], GL_STATIC_DRAW);
-
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)nullptr);
-        }
-        glBindVertexArray(0);
+        vao = gl::VertexArray::create();
+        vao.vertexBuffer(0, vbo, sizeof(glm::vec3));
+        vao.attribute(0, 0, 3, GL_FLOAT, false, 0);
     }
 
-    GLuint vao, vbo;
-    vector<glm::vec3> vertices;
-    GLuint cubemap;
+    gl::VertexArray vao;
+    gl::Buffer vbo;
+    std::vector<glm::vec3> vertices;
+    std::vector<std::string> filenames;
+    gl::Texture cubemap;
 };
 // ///////////////////////////////////////////////////////////////////// //
 #endif // SKYBOX_H
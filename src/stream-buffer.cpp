@@ -0,0 +1,124 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "stream-buffer.hpp"
+#include "frame-stats.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::runtime_error;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    GLbitfield const MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                                 GL_MAP_COHERENT_BIT;
+
+    GLintptr alignUp(GLintptr const offset, GLsizeiptr const alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+}
+
+// ///////////////////////////////////////////////// Class: StreamBuffer //
+// ==================================================== Public interface ==
+// ----------------------------------------------------------- Behaviour --
+StreamBuffer::StreamBuffer(GLsizeiptr const regionSize)
+        : mapped(nullptr), regionSize(0), region(0), used(0), fences{} {
+    GLint alignment;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    storageOffsetAlignment = alignment;
+
+    create(regionSize);
+}
+
+StreamBuffer::~StreamBuffer() {
+    deleteFences();
+}
+
+void StreamBuffer::beginFrame() {
+    region = (region + 1) % FRAMES;
+    used = 0;
+
+    GLsync &fence = fences[region];
+    if (fence == nullptr) {
+        return;
+    }
+    for (;;) {
+        GLenum const status = glClientWaitSync(
+                fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT);
+        if (status == GL_ALREADY_SIGNALED ||
+            status == GL_CONDITION_SATISFIED) {
+            break;
+        }
+        if (status == GL_WAIT_FAILED) {
+            throw runtime_error("Failed to wait for a stream buffer fence!");
+        }
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::endFrame() {
+    if (fences[region] != nullptr) {
+        glDeleteSync(fences[region]);
+    }
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(GLsizeiptr const size,
+                                                GLsizeiptr const alignment) {
+    GLintptr offset = alignUp(used, alignment);
+    if (offset + size > regionSize) {
+        create(std::max<GLsizeiptr>(2 * regionSize, alignUp(size, alignment)));
+        offset = 0;
+    }
+    used = offset + size;
+
+    stats::current().bufferUploads++;
+    stats::current().bufferUploadBytes += size;
+
+    GLintptr const start = region * regionSize + offset;
+    return Allocation{buffer.id(), start, mapped + start};
+}
+
+StreamBuffer::Allocation StreamBuffer::upload(void const *data,
+                                              GLsizeiptr const size,
+                                              GLsizeiptr const alignment) {
+    Allocation const allocation = allocate(size, alignment);
+    std::memcpy(allocation.data, data, size);
+    return allocation;
+}
+
+GLsizeiptr StreamBuffer::storageAlignment() const {
+    return storageOffsetAlignment;
+}
+
+// ============================================== Private implementation ==
+// ----------------------------------------------------------- Behaviour --
+void StreamBuffer::create(GLsizeiptr const minimumRegionSize) {
+    // The old ring's fences guard a buffer that is now released
+    deleteFences();
+
+    // Regions start at multiples of the size, and ranges in any of them
+    // may be bound as shader storage
+    regionSize = alignUp(minimumRegionSize, storageOffsetAlignment);
+    buffer = gl::Buffer(FRAMES * regionSize, nullptr, MAP_FLAGS,
+                        resources::CATEGORY_STREAMING);
+    mapped = static_cast<unsigned char *>(glMapNamedBufferRange(
+            buffer.id(), 0, FRAMES * regionSize, MAP_FLAGS));
+    if (mapped == nullptr) {
+        throw runtime_error("Failed to map the stream buffer!");
+    }
+    used = 0;
+}
+
+void StreamBuffer::deleteFences() {
+    for (auto &fence : fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+}
+
+// ///////////////////////////////////////////////////////////////////// //
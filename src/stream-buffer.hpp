@@ -0,0 +1,75 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "opengl-headers.hpp"
+#include "gl-resources.hpp"
+
+// ///////////////////////////////////////////////// Class: StreamBuffer //
+// Ring of FRAMES equal regions in one buffer that stays mapped, persistent
+// and coherent, for everything rewritten every frame: text, the UI,
+// per-draw data and lights. A frame writes its region through the
+// pointer and draws from it by offset; the region isn't touched again
+// until the fence placed at the end of that frame has passed, FRAMES
+// frames later. Nothing is orphaned and the driver never has to
+// synchronize an upload with draws still in flight.
+//
+// When a frame needs more than a region holds, the ring is replaced by
+// a larger one. The old buffer lives until the GPU is done with it (see
+// resource-manager.hpp), so allocations made before stay valid.
+class StreamBuffer {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Constants --
+    static constexpr int FRAMES = 3;
+    static constexpr GLsizeiptr INITIAL_REGION_SIZE = 1 << 20;
+
+    // How long to wait for a region at once, in nanoseconds
+    static constexpr GLuint64 WAIT_TIMEOUT = 1000000;
+
+    // ------------------------------------------------------- Behaviour --
+    struct Allocation {
+        GLuint buffer;
+        GLintptr offset;
+        void *data;
+    };
+
+    explicit StreamBuffer(GLsizeiptr const regionSize = INITIAL_REGION_SIZE);
+    ~StreamBuffer();
+
+    StreamBuffer(StreamBuffer const &) = delete;
+    StreamBuffer &operator=(StreamBuffer const &) = delete;
+
+    // Moves to the next region, waiting until the GPU has finished the
+    // frame that wrote it last
+    void beginFrame();
+
+    // Fences the region written during the frame
+    void endFrame();
+
+    // Room for size bytes at a multiple of alignment, to be written
+    // before the frame's commands that read it are submitted
+    Allocation allocate(GLsizeiptr const size, GLsizeiptr const alignment);
+
+    // Copies the data into a new allocation
+    Allocation upload(void const *data, GLsizeiptr const size,
+                      GLsizeiptr const alignment);
+
+    // Alignment of ranges bound as shader storage
+    GLsizeiptr storageAlignment() const;
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------- Behaviour --
+    void create(GLsizeiptr const minimumRegionSize);
+    void deleteFences();
+
+    // ------------------------------------------------------------ Data --
+    gl::Buffer buffer;
+    unsigned char *mapped;
+    GLsizeiptr storageOffsetAlignment;
+    GLsizeiptr regionSize;
+    int region;
+    GLintptr used;
+    GLsync fences[FRAMES];
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // STREAM_BUFFER_H
@@ -0,0 +1,200 @@
+// //////////////////////////////////////////////////////////// Includes //
+#include "tangent-space.hpp"
+#include "cache.hpp"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// ////////////////////////////////////////////////////////////// Usings //
+using std::size_t;
+using std::vector;
+
+using glm::vec2;
+using glm::vec3;
+using glm::vec4;
+
+// ///////////////////////////////////////////////////////////// Helpers //
+namespace {
+    float const EPSILON = 1e-12f;
+
+    // Corners sharing a key share a tangent; floats only, so that there
+    // is no padding to hash or compare
+    struct CornerKey {
+        vec3 position;
+        vec3 normal;
+        vec2 texCoords;
+        float sign;
+    };
+
+    struct CornerKeyHash {
+        size_t operator()(CornerKey const &key) const {
+            return static_cast<size_t>(cache::hash(&key, sizeof(key)));
+        }
+    };
+
+    struct CornerKeyEqual {
+        bool operator()(CornerKey const &a, CornerKey const &b) const {
+            return std::memcmp(&a, &b, sizeof(CornerKey)) == 0;
+        }
+    };
+
+    // Calls function(begin, end) over [0, count) split between threads
+    template <typename Function>
+    void parallelFor(size_t const count, Function const &function) {
+        size_t const batches = (count + tangents::BATCH_SIZE - 1) /
+                               tangents::BATCH_SIZE;
+        size_t const threads = std::max<size_t>(
+                1, std::min<size_t>(std::thread::hardware_concurrency(),
+                                    batches));
+        size_t const chunk = (count + threads - 1) / threads;
+
+        vector<std::thread> workers;
+        for (size_t thread = 1; thread < threads; ++thread) {
+            size_t const begin = std::min(count, thread * chunk);
+            size_t const end = std::min(count, begin + chunk);
+            workers.emplace_back(function, begin, end);
+        }
+        function(size_t(0), std::min(count, chunk));
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    float cornerAngle(vec3 const &corner, vec3 const &a, vec3 const &b) {
+        vec3 const edgeA = a - corner, edgeB = b - corner;
+        float const lengths = glm::length(edgeA) * glm::length(edgeB);
+        if (lengths < EPSILON) {
+            return 0.0f;
+        }
+        return glm::acos(glm::clamp(glm::dot(edgeA, edgeB) / lengths,
+                                    -1.0f, 1.0f));
+    }
+
+    // Any unit vector perpendicular to the normal, for corners whose
+    // texture coordinates don't define a tangent
+    vec3 perpendicular(vec3 const &normal) {
+        vec3 const axis = glm::abs(normal.x) < 0.9f
+                          ? vec3(1.0f, 0.0f, 0.0f)
+                          : vec3(0.0f, 1.0f, 0.0f);
+        return glm::normalize(glm::cross(normal, axis));
+    }
+}
+
+// //////////////////////////////////////////////////////// Tangent space //
+void tangents::generate(vector<Vertex> &vertices,
+                        vector<unsigned int> &indices) {
+    size_t const cornerCount = indices.size() - indices.size() % 3;
+
+    // Angle-weighted tangent in each corner's tangent plane, and the
+    // handedness of the triangle's texture mapping
+    vector<vec3> cornerTangents(cornerCount);
+    vector<float> cornerSigns(cornerCount);
+    parallelFor(cornerCount / 3, [&](size_t const begin, size_t const end) {
+        for (size_t triangle = begin; triangle < end; ++triangle) {
+            Vertex const *corners[3];
+            for (int corner = 0; corner < 3; ++corner) {
+                corners[corner] = &vertices[indices[3 * triangle + corner]];
+            }
+
+            vec3 const edge1 = corners[1]->position - corners[0]->position;
+            vec3 const edge2 = corners[2]->position - corners[0]->position;
+            vec2 const delta1 = corners[1]->texCoords - corners[0]->texCoords;
+            vec2 const delta2 = corners[2]->texCoords - corners[0]->texCoords;
+
+            vec3 tangent(0.0f), bitangent(0.0f);
+            float const determinant = delta1.x * delta2.y - delta2.x * delta1.y;
+            if (glm::abs(determinant) > EPSILON) {
+                tangent = (edge1 * delta2.y - edge2 * delta1.y) / determinant;
+                bitangent = (edge2 * delta1.x - edge1 * delta2.x) / determinant;
+            }
+
+            for (int corner = 0; corner < 3; ++corner) {
+                size_t const i = 3 * triangle + corner;
+                vec3 const &normal = corners[corner]->normal;
+
+                vec3 const projected =
+                        tangent - normal * glm::dot(normal, tangent);
+                float const length = glm::length(projected);
+                cornerTangents[i] = length > EPSILON
+                        ? projected / length *
+                          cornerAngle(corners[corner]->position,
+                                      corners[(corner + 1) % 3]->position,
+                                      corners[(corner + 2) % 3]->position)
+                        : vec3(0.0f);
+                cornerSigns[i] = glm::dot(glm::cross(normal, tangent),
+                                          bitangent) < 0.0f ? -1.0f : 1.0f;
+            }
+        }
+    });
+
+    // Group the corners, the index buffer alone would miss vertices that
+    // are only duplicated for other attributes
+    std::unordered_map<CornerKey, unsigned int, CornerKeyHash,
+                       CornerKeyEqual> groups;
+    vector<unsigned int> cornerGroups(cornerCount);
+    vector<vec3> groupTangents;
+    vector<vec3> groupNormals;
+    for (size_t i = 0; i < cornerCount; ++i) {
+        Vertex const &vertex = vertices[indices[i]];
+        CornerKey const key = {vertex.position, vertex.normal,
+                               vertex.texCoords, cornerSigns[i]};
+
+        auto const inserted = groups.emplace(
+                key, static_cast<unsigned int>(groupTangents.size()));
+        if (inserted.second) {
+            groupTangents.push_back(vec3(0.0f));
+            groupNormals.push_back(vertex.normal);
+        }
+        cornerGroups[i] = inserted.first->second;
+        groupTangents[cornerGroups[i]] += cornerTangents[i];
+    }
+
+    parallelFor(groupTangents.size(), [&](size_t const begin,
+                                          size_t const end) {
+        for (size_t group = begin; group < end; ++group) {
+            float const length = glm::length(groupTangents[group]);
+            groupTangents[group] = length > EPSILON
+                    ? groupTangents[group] / length
+                    : perpendicular(groupNormals[group]);
+        }
+    });
+
+    // A vertex keeps the handedness it's first used with, corners of the
+    // other one move to a copy
+    vector<float> vertexSigns(vertices.size(), 0.0f);
+    vector<unsigned int> copies(vertices.size(), 0);
+    size_t const vertexCount = vertices.size();
+    for (size_t i = 0; i < cornerCount; ++i) {
+        unsigned int const vertex = indices[i];
+        float const sign = cornerSigns[i];
+        vec4 const tangent(groupTangents[cornerGroups[i]], sign);
+
+        if (vertexSigns[vertex] == 0.0f) {
+            vertexSigns[vertex] = sign;
+            vertices[vertex].tangent = tangent;
+        } else if (vertexSigns[vertex] != sign) {
+            if (copies[vertex] == 0) {
+                copies[vertex] = static_cast<unsigned int>(vertices.size());
+                Vertex copy = vertices[vertex];
+                copy.tangent = tangent;
+                vertices.push_back(copy);
+            }
+            indices[i] = copies[vertex];
+        }
+    }
+
+    // Vertices no triangle uses still need a valid tangent
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        if (vertexSigns[vertex] == 0.0f) {
+            vertices[vertex].tangent =
+                    vec4(perpendicular(vertices[vertex].normal), 1.0f);
+        }
+    }
+}
+
+// ///////////////////////////////////////////////////////////////////// //
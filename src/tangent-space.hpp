@@ -0,0 +1,24 @@
+#ifndef TANGENT_SPACE_H
+#define TANGENT_SPACE_H
+// //////////////////////////////////////////////////////////// Includes //
+#include "mesh.hpp"
+
+#include <vector>
+
+// //////////////////////////////////////////////////////// Tangent space //
+// Per-vertex tangents following MikkTSpace's conventions, so that normal
+// maps baked by common tools decode without seams: face tangents are
+// projected onto the vertex normal and averaged weighted by the corner
+// angle, over all corners with the same position, normal, texture
+// coordinates and handedness. The bitangent is tangent.w * cross(normal,
+// tangent); vertices used with both handednesses are split.
+namespace tangents {
+    // Triangles per worker thread, below which the work isn't split
+    int const BATCH_SIZE = 4096;
+
+    void generate(std::vector<Vertex> &vertices,
+                  std::vector<unsigned int> &indices);
+}
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // TANGENT_SPACE_H
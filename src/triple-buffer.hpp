@@ -0,0 +1,85 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+// //////////////////////////////////////////////////////////// Includes //
+#include <array>
+#include <atomic>
+
+// ///////////////////////////////////////////////// Class: TripleBuffer //
+// Passes values from one producer thread to one consumer thread without
+// locks. Of the three slots the producer owns one, the consumer another,
+// and the third is in between. Publishing swaps the producer's slot with
+// the one in between and marks it fresh; the consumer swaps a fresh one
+// for its own. Neither side ever waits for the other, and the consumer
+// always gets the latest value published. Slots are reused, so values
+// that hold containers keep their storage from one round to the next.
+template <typename T>
+class TripleBuffer {
+public: // ============================================ Public interface ==
+    // ------------------------------------------------------- Behaviour --
+    TripleBuffer() : shared(1), writing(0), reading(2) {
+    }
+
+    TripleBuffer(TripleBuffer const &) = delete;
+    TripleBuffer &operator=(TripleBuffer const &) = delete;
+
+    // Producer: the slot to fill; it still holds an older value, to be
+    // overwritten
+    T &write() {
+        return slots[writing];
+    }
+
+    // Producer: hands the filled slot over to the consumer
+    void publish() {
+        writing = shared.exchange(writing | FRESH,
+                                  std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Consumer: takes the latest published value, if there is one it
+    // hasn't taken yet
+    bool update() {
+        if (!pending()) {
+            return false;
+        }
+        reading = shared.exchange(reading,
+                                  std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    // Consumer: the value taken by the last successful update
+    T &read() {
+        return slots[reading];
+    }
+
+    // Whether a published value is still waiting for the consumer
+    bool pending() const {
+        return (shared.load(std::memory_order_acquire) & FRESH) != 0;
+    }
+
+    // Resets every slot; only while neither thread uses the buffer
+    void clear() {
+        for (T &slot : slots) {
+            slot = T();
+        }
+        shared.store(1, std::memory_order_release);
+        writing = 0;
+        reading = 2;
+    }
+
+private: // ===================================== Private implementation ==
+    // ------------------------------------------------------- Constants --
+    static constexpr int INDEX = 3;
+    static constexpr int FRESH = 4;
+
+    // ------------------------------------------------------------ Data --
+    std::array<T, 3> slots;
+
+    // Index of the slot in between and its fresh bit; the indices on
+    // either side belong to one thread each and sit on their own cache
+    // lines so that the threads don't contend for them
+    alignas(64) std::atomic<int> shared;
+    alignas(64) int writing;
+    alignas(64) int reading;
+};
+
+// ///////////////////////////////////////////////////////////////////// //
+#endif // TRIPLE_BUFFER_H